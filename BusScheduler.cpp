@@ -0,0 +1,140 @@
+#include "BusScheduler.h"
+
+/* Constructor */
+BusScheduler::BusScheduler(UHFRecv& uhf): _uhf(uhf)
+{
+    _numReaders = 0;
+    _current = 0;
+    _isBusy = false;
+
+    _period = 0;
+    _sweepStart = 0;
+    _sweepStartUs = 0;
+    _sweepTime = 0;
+    _numSweeps = 0;
+
+    _callback = NULL;
+    _context = NULL;
+}
+
+/**
+* @public
+* @brief Add a reader to the bus
+*/
+Status BusScheduler::addReader(InventorySession& session, const byte address,
+                               const uint16_t timeout)
+{
+    if (_numReaders >= BUS_MAX_READERS)
+        return ERR_QUEUE_FULL;
+
+    Reader& reader = _readers[_numReaders++];
+    reader.session = &session;
+    reader.timeout = timeout;
+    reader.lastStatus = STATUS_SUCCESS;
+
+    // setCommand() builds the command in a buffer of the shared `UHFRecv`
+    memcpy(reader.request, _uhf.setCommand(address, TID_ARRESSS, LENGTH_TID),
+           sizeof(reader.request));
+
+    return STATUS_SUCCESS;
+}
+
+/* Set the function called when an inventory session is finished */
+void BusScheduler::setCallback(SessionCallback callback, void* context)
+{
+    _callback = callback;
+    _context = context;
+}
+
+/* Set the minimum time (ms) between the starts of 2 sweeps */
+void BusScheduler::setPeriod(const uint32_t period)
+{
+    _period = period;
+}
+
+/**
+* @public
+* @brief Advance the sweep (non-blocking)
+*/
+void BusScheduler::poll()
+{
+    if (_numReaders == 0)
+        return;
+
+    if (!_isBusy && !_start())
+        return;
+
+    Reader& reader = _readers[_current];
+    Status status = reader.session->poll();
+    if (status == STATUS_RS485_BUSY)
+        return;
+
+    _isBusy = false;
+    reader.lastStatus = status;
+    if (_callback)
+        _callback(_current, status, _context);
+
+    if (++_current == _numReaders) {
+        _current = 0;
+        _sweepTime = micros() - _sweepStartUs;
+        _numSweeps++;
+    }
+
+    // The bus is free: send the next command now, not in the next loop()
+    _start();
+}
+
+/* Get number of readers */
+byte BusScheduler::getNumReaders()
+{
+    return _numReaders;
+}
+
+/* Get index of the reader being inventoried (or the next one) */
+byte BusScheduler::getCurrentReader()
+{
+    return _current;
+}
+
+/* Get the status of the last session of a reader */
+Status BusScheduler::getLastStatus(const byte reader)
+{
+    return _readers[reader].lastStatus;
+}
+
+/* Get the duration (us) of the last complete sweep */
+uint32_t BusScheduler::getSweepTime()
+{
+    return _sweepTime;
+}
+
+/* Get number of complete sweeps */
+uint32_t BusScheduler::getNumSweeps()
+{
+    return _numSweeps;
+}
+
+/**
+* @private
+* @brief Start the session of the current reader
+*/
+bool BusScheduler::_start()
+{
+    uint32_t now = millis();
+    uint32_t nowUs = micros();
+    if ((_current == 0) && (_numSweeps > 0) && (now - _sweepStart < _period))
+        return false; //< The next sweep is not due yet
+
+    Reader& reader = _readers[_current];
+    _uhf.setTimeout(reader.timeout);
+    if (reader.session->start(reader.request, sizeof(reader.request))
+        != STATUS_SUCCESS)
+        return false; //< e.g. the bus is used by someone else, retry next time
+
+    if (_current == 0) { //< Start of a sweep
+        _sweepStart = now;
+        _sweepStartUs = nowUs;
+    }
+    _isBusy = true;
+    return true;
+}
@@ -0,0 +1,145 @@
+#ifndef _BUS_SCHEDULER_H_
+#define _BUS_SCHEDULER_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "InventorySession.h"
+#include "UHFRecv.h"
+
+// Maximum number of readers on one RS485 bus
+#ifndef BUS_MAX_READERS
+#define BUS_MAX_READERS              8
+#endif
+
+/*
+* @brief Round-robin inventory of several readers on one RS485 bus
+* @detail Readers with different addresses share one `UHFRecv` (one serial
+* port and one RS485 transceiver). The bus is half-duplex, so one inventory
+* session runs at a time: as soon as the session of a reader is finished
+* (complete, error or time-out), the inventory command of the next reader is
+* sent, in the same poll(). A sweep (every reader once) therefore takes about
+* the sum of the wire times of the requests and responses, there is no
+* `period` between readers.
+*
+* - Each reader has its own `InventorySession` (and `Database`), built on
+*   the shared `UHFRecv`, its own inventory command and response timeout.
+* - setPeriod() sets the minimum time between the starts of 2 sweeps (0:
+*   back to back).
+*
+* @example
+* ```
+*     UHFRecv uhf(Serial1, BAUD_RATE, RS485_CONTROL);
+*     Database databases[2];
+*     InventorySession session0(uhf, databases[0]), session1(uhf, databases[1]);
+*     BusScheduler bus(uhf);
+*
+*     void setup()
+*     {
+*         uhf.begin();
+*         bus.addReader(session0, 0x00, DEFAULT_RX_TIMEOUT);
+*         bus.addReader(session1, 0x01, DEFAULT_RX_TIMEOUT);
+*         bus.setCallback(onSession, NULL);
+*     }
+*
+*     void loop()
+*     {
+*         bus.poll(); //< Never blocks
+*     }
+* ```
+*/
+class BusScheduler
+{
+public:
+    /**
+    * Called when an inventory session of a reader is finished.
+    * - reader: index of the reader (order of addReader()).
+    * - status: return value of `InventorySession::poll()`.
+    * - context: pointer given to setCallback().
+    */
+    typedef void (*SessionCallback)(byte reader, Status status, void* context);
+
+    /**
+    * @brief Constructor
+    * @param
+    * - uhf: UHF receiver of the bus, shared by the sessions of every reader.
+    */
+    BusScheduler(UHFRecv& uhf);
+
+    /**
+    * @brief Add a reader to the bus
+    *
+    * @param
+    * - session: inventory session of the reader, built on the `UHFRecv` of
+    *   the bus.
+    * - address: reader address (0x00 - 0xFE).
+    * - timeout: time (ms) from the end of the request to the end of each
+    *   response frame of this reader.
+    *
+    * @return
+    * - STATUS_SUCCESS: the reader is added.
+    * - ERR_QUEUE_FULL: there are already `BUS_MAX_READERS` readers.
+    */
+    Status addReader(InventorySession& session, const byte address,
+                     const uint16_t timeout);
+
+    /* Set the function called when an inventory session is finished */
+    void setCallback(SessionCallback callback, void* context);
+
+    /* Set the minimum time (ms) between the starts of 2 sweeps */
+    void setPeriod(const uint32_t period);
+
+    /**
+    * @brief Advance the sweep (non-blocking)
+    * @detail Call this function from `loop()`. It polls the session in
+    * progress and starts the session of the next reader once it is finished.
+    * @param none
+    * @return none
+    */
+    void poll();
+
+    /* Get number of readers */
+    byte getNumReaders();
+
+    /* Get index of the reader being inventoried (or the next one) */
+    byte getCurrentReader();
+
+    /* Get the status of the last session of a reader */
+    Status getLastStatus(const byte reader);
+
+    /* Get the duration (us) of the last complete sweep */
+    uint32_t getSweepTime();
+
+    /* Get number of complete sweeps */
+    uint32_t getNumSweeps();
+
+private:
+    typedef struct {
+        InventorySession* session;
+        byte request[7]; //< Inventory command (see `UHFRecv::setCommand()`)
+        uint16_t timeout;
+        Status lastStatus;
+    } Reader;
+
+    /* Start the session of the current reader, return true if it is started */
+    bool _start();
+
+    UHFRecv& _uhf;
+    Reader _readers[BUS_MAX_READERS];
+    byte _numReaders;
+    byte _current; //< Reader being inventoried (or the next one)
+    bool _isBusy; //< A session is in progress
+
+    uint32_t _period;
+    uint32_t _sweepStart; //< millis() of the start of the sweep
+    uint32_t _sweepStartUs; //< micros() of the start of the sweep
+    uint32_t _sweepTime;
+    uint32_t _numSweeps;
+
+    SessionCallback _callback;
+    void* _context;
+};
+
+#endif
@@ -2,71 +2,212 @@
 #define _CQUEUE_H
 
 #include <Arduino.h>
-#include <Keyboard.h>
 
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "attribute.h"
 
+/*
+* @brief Circular queue
+*
+* - T: data type of elements in the queue (e.g. Card, byte, char, int, etc.)
+* - Capacity: maximum number of elements. Power-of-two capacities wrap indices
+*   with a mask, other capacities with a compare, there is no division.
+* - Index: data type of indices, must be able to hold `Capacity` (e.g. `byte`
+*   for the 25-card AVR database, `uint16_t` or `uint32_t` for host builds).
+*
+* @example
+* ```
+*     CQueue<Card, 25> cards;
+*     for (CQueue<Card, 25>::Iterator it = cards.begin(); it != cards.end(); ++it)
+*         prtCardInfo(&(*it));
+* ```
+*/
+template <typename T, size_t Capacity, typename Index = byte>
 class CQueue
 {
 public:
     // Data type of elements in the queue
-    typedef Card QDataType; /* Change `Card` to any data type you want
-                               (e.g. byte, char, int, etc.) */   
+    typedef T QDataType;
 
     // Pass pointer to function to another function (call back function)
     typedef void (*CallBackFunc) (QDataType*); //< [WARNING] POINTER HERE IS IMPORTANT
 
-    CQueue(); //< Default constructor
-    
-    bool isEmpty();
-    bool isFull();
+    /* Iterator over the elements, from the head to the tail of the queue */
+    class Iterator
+    {
+    public:
+        Iterator(CQueue* queue, size_t pos): _queue(queue), _pos(pos) {}
+
+        QDataType& operator*() const { return _queue->_data[_slot()]; }
+        QDataType* operator->() const { return &(_queue->_data[_slot()]); }
+
+        /* Slot of the element in the queue's array (see getQueueData()) */
+        Index getSlot() const { return _slot(); }
+
+        Iterator& operator++()
+        {
+            _pos++;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const { return _pos == other._pos; }
+        bool operator!=(const Iterator& other) const { return _pos != other._pos; }
+
+    private:
+        Index _slot() const
+        {
+            size_t slot = _queue->_head + _pos;
+            return (Index)((slot >= Capacity) ? slot - Capacity : slot);
+        }
+
+        CQueue* _queue;
+        size_t _pos; //< Position from the head of the queue
+    };
+
+    /* Default constructor */
+    CQueue()
+    {
+        _size = 0;
+        _head = 0;
+        _tail = Capacity - 1; //< The first element is enqueued to slot 0
+
+        memset(_data, 0, sizeof(_data));
+    }
+
+    bool isEmpty()
+    {
+        return (_size == 0);
+    }
+
+    bool isFull()
+    {
+        return (_size == Capacity);
+    }
 
     /**
     * @brief Enqueue data
-    * @param 
+    * @param
     *    - data: data (const) need to be enqueued
-    * @return 
+    * @return
     *    - STATUS_SUCCESS: Enqueue data successfully.
     *    - ERR_QUEUE_FULL: the queue is full, can not enqueue anymore.
     */
-    Status enqueue(const QDataType data);
+    Status enqueue(const QDataType& data)
+    {
+        if (isFull()) {
+            return ERR_QUEUE_FULL; //< the queue is full, can not enqueue anymore
+        }
+
+        _tail = _next(_tail);
+        _data[_tail] = data;
+        _size++;
+
+        return STATUS_SUCCESS;
+    }
 
     /**
     * @brief Dequeue the top element of the queue
     * @param none
-    * @return 
+    * @return
     *    - STATUS_SUCCESS: Enqueue data successfully.
     *    - ERR_QUEUE_EMPTY: the queue is empty, can not dequeue anymore.
     */
-    Status dequeue();
+    Status dequeue()
+    {
+        if (isEmpty()) {
+            return ERR_QUEUE_EMPTY; //< the queue is empty, can not dequeue
+        }
+
+        _head = _next(_head);
+        _size--;
+
+        return STATUS_SUCCESS;
+    }
+
+    /* Get the element at the head of the queue (must not be empty) */
+    QDataType& front()
+    {
+        return _data[_head];
+    }
+
+    /* Remove every element of the queue */
+    void clear()
+    {
+        _size = 0;
+        _head = 0;
+        _tail = Capacity - 1;
+    }
+
+    //< Get queue's size at the moment this func is called
+    Index getSize()
+    {
+        return _size;
+    }
 
-    const byte getSize(); //< Get queue's size at the moment this func is called
-    const byte getCapacity(); //< Get capacity of the queue
+    //< Get capacity of the queue
+    Index getCapacity()
+    {
+        return Capacity;
+    }
 
-    QDataType* getQueueData(); //< return pointer to the first element of 
-                               //  the queue array
+    /* Slot of the last enqueued element in the queue's array */
+    Index getTailSlot()
+    {
+        return _tail;
+    }
+
+    //< return pointer to the first element of the queue array
+    QDataType* getQueueData()
+    {
+        return _data;
+    }
+
+    Iterator begin()
+    {
+        return Iterator(this, 0);
+    }
+
+    Iterator end()
+    {
+        return Iterator(this, _size);
+    }
 
     /**
     * @public
     * @brief Debug function
-    * @param pointer to the data-displaying function 
+    * @param pointer to the data-displaying function
     * @return none
     */
-    void _debugPrint(CallBackFunc func);
+    void _debugPrint(CallBackFunc cbFunc) //< Pointer to function
+    {
+        for (Iterator it = begin(); it != end(); ++it) {
+            /* Execute `cbFunc` which is passed as an argument to _debugPrint */
+            cbFunc(&(*it));
+        }
+        Serial.println();
+    }
 
 private:
-    enum QueueInfo: byte {
-        _CAPACITY = 25 //< Maximum capacity of the queue
-    };
+    /* Next slot, wrapped around the end of the queue's array */
+    static Index _next(Index i)
+    {
+        if ((Capacity & (Capacity - 1)) == 0)
+            return (Index)((i + 1) & (Capacity - 1));
+        return (i + 1 == Capacity) ? 0 : (Index)(i + 1);
+    }
+
+    Index _size; //< Keep track of queue's size
+    Index _head;
+    Index _tail;
+
+    QDataType _data[Capacity]; //< Queue's data
 
-    byte _size; //< Keep track of queue's size
-    
-    int8_t _head; //< Pay attention to data type of `_head` and `_tail` is 
-    int8_t _tail; //  `int8_t` not `byte`.
-    
-    QDataType _data[_CAPACITY]; //< Queue's data
+    static_assert(Capacity > 0, "Capacity of CQueue must be positive");
+    static_assert((size_t)(Index)~(Index)0 >= Capacity,
+                  "Index of CQueue is too small to hold its Capacity");
 };
 
 #endif
@@ -0,0 +1,71 @@
+#ifndef _COMMAND_H_
+#define _COMMAND_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "Crc16.h"
+
+/*
+* @brief Command frames built at compile time
+* @detail The CRC-16 of a command whose parameters are constants (e.g. from
+* `attribute.h`) is computed by the compiler, the whole frame is a constant
+* array stored in flash (PROGMEM) on AVR. Sending it only costs the serial
+* write (see `UHFRecv::sendRequest_P()` and `InventorySession::start_P()`).
+*
+* Commands with parameters known at run time only are built by
+* `UHFRecv::setCommand()`, which keeps the last command (no CRC if the
+* parameters did not change).
+*
+* @example
+* ```
+*     typedef InventoryCommand<READER_ADDRESS, TID_ARRESSS, LENGTH_TID> Inventory;
+*
+*     session->start_P(Inventory::frame, Inventory::SIZE);
+* ```
+*/
+
+/* CRC-16 (polynomial of 0x8408) of `bits` more bits, see `Crc16.h` */
+constexpr uint16_t crc16Bits(const uint16_t crc, const byte bits)
+{
+    return (bits == 0) ? crc
+           : crc16Bits((crc & 0x0001) ? ((crc >> 1) ^ 0x8408) : (crc >> 1), bits - 1);
+}
+
+/* CRC-16 of one more byte, computed at compile time if `data` is constant */
+constexpr uint16_t crc16Byte(const uint16_t crc, const byte data)
+{
+    return crc16Bits(crc ^ data, 8);
+}
+
+/*
+* @brief Inventory command (see `doc/Protocols` and `UHFRecv::setCommand()`)
+* - Address: reader address (0xFF: broadcast).
+* - TidAddress: entry address of inventory TID memory.
+* - TidLength: data length (words) for TID inventory operation.
+*/
+template <byte Address, byte TidAddress, byte TidLength>
+struct InventoryCommand
+{
+    static const size_t SIZE = 7; //< Len, Adr, Cmd, 2 parameters, CRC-16
+
+    static constexpr uint16_t CRC =
+        crc16Byte(crc16Byte(crc16Byte(crc16Byte(crc16Byte(CRC16_INIT,
+            SIZE - 1), Address), 0x01), TidAddress), TidLength);
+
+    static const byte frame[SIZE]; //< In flash on AVR (PROGMEM)
+};
+
+template <byte Address, byte TidAddress, byte TidLength>
+constexpr uint16_t InventoryCommand<Address, TidAddress, TidLength>::CRC;
+
+// CRC-16 is sent low byte first
+template <byte Address, byte TidAddress, byte TidLength>
+const byte InventoryCommand<Address, TidAddress, TidLength>::frame[SIZE] PROGMEM = {
+    SIZE - 1, Address, 0x01, TidAddress, TidLength,
+    (byte)(CRC & 0xFF), (byte)(CRC >> 8)
+};
+
+#endif
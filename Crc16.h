@@ -0,0 +1,86 @@
+#ifndef _CRC16_H_
+#define _CRC16_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* CRC-16 engines used by the PK-UHF101U protocol (see `doc/Protocols`).
+*
+* - Polynomial: 0x8408 (reflected 0x1021), initial value: 0xFFFF, no final XOR.
+* - Every engine below returns exactly the same result, they only differ in
+*   speed and in the amount of flash used by their lookup tables:
+*
+* +----------------------+-------------+-------------------------------------+
+* | Engine               | Table size  | Notes                               |
+* +----------------------+-------------+-------------------------------------+
+* | CRC16_ENGINE_BITWISE |      0 bytes| 8 shift/branch steps per byte       |
+* | CRC16_ENGINE_NIBBLE  |     32 bytes| 2 lookups per byte (AVR default)    |
+* | CRC16_ENGINE_TABLE   |    512 bytes| 1 lookup per byte                   |
+* | CRC16_ENGINE_SLICE4  |   2048 bytes| 4 bytes per step (host default,     |
+* |                      |             | not available on AVR)               |
+* +----------------------+-------------+-------------------------------------+
+*
+* On AVR the tables are stored in flash (PROGMEM).
+*
+* @note
+* To select an engine, define `UHF_CRC_ENGINE` before this header is included
+* (e.g. `-DUHF_CRC_ENGINE=CRC16_ENGINE_TABLE`).
+*/
+#define CRC16_ENGINE_BITWISE         0
+#define CRC16_ENGINE_NIBBLE          1
+#define CRC16_ENGINE_TABLE           2
+#define CRC16_ENGINE_SLICE4          3
+
+#ifndef UHF_CRC_ENGINE
+    #if defined(__AVR__)
+        #define UHF_CRC_ENGINE       CRC16_ENGINE_NIBBLE
+    #else
+        #define UHF_CRC_ENGINE       CRC16_ENGINE_SLICE4
+    #endif
+#endif
+
+#if defined(__AVR__) && (UHF_CRC_ENGINE == CRC16_ENGINE_SLICE4)
+    #error "CRC16_ENGINE_SLICE4 is not available on AVR"
+#endif
+
+#define CRC16_INIT                   0xFFFF
+
+/**
+* @brief CRC-16 engines (polynomial of 0x8408)
+* @detail The CRC is computed in the reflected bit order used on the wire, i.e.
+* the low byte of the result is transmitted first.
+*
+* @param
+* - crc: running CRC value (`CRC16_INIT` for a new frame).
+* - data: array of bytes of data needed to calculate checksum.
+* - size: number of elements in array.
+*
+* @return updated 16 bits of CRC-16 checksum
+*/
+uint16_t crc16Bitwise(uint16_t crc, const uint8_t* data, size_t size);
+uint16_t crc16Nibble(uint16_t crc, const uint8_t* data, size_t size);
+uint16_t crc16Table(uint16_t crc, const uint8_t* data, size_t size);
+#if !defined(__AVR__)
+uint16_t crc16Slice4(uint16_t crc, const uint8_t* data, size_t size);
+#endif
+
+/**
+* @brief CRC-16 with the engine selected by `UHF_CRC_ENGINE`
+* @param see crc16Bitwise()
+* @return updated 16 bits of CRC-16 checksum
+*/
+inline uint16_t crc16Update(uint16_t crc, const uint8_t* data, size_t size)
+{
+#if (UHF_CRC_ENGINE == CRC16_ENGINE_BITWISE)
+    return crc16Bitwise(crc, data, size);
+#elif (UHF_CRC_ENGINE == CRC16_ENGINE_NIBBLE)
+    return crc16Nibble(crc, data, size);
+#elif (UHF_CRC_ENGINE == CRC16_ENGINE_TABLE)
+    return crc16Table(crc, data, size);
+#else
+    return crc16Slice4(crc, data, size);
+#endif
+}
+
+#endif
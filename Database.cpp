@@ -1,20 +1,6 @@
 #include "Database.h"
 
-/*
-* @note
-* - `timeFlag` is used to ensure that timestamps are set once only for each 
-* inventoried card. Initialise to `true`.
-* - Make sure every time calling inventoryCards(), a timeFlag is wrapped 
-* around.
-* @example: 
-* ```
-*     timeFlag = true;
-*     Status status = inventoryCards(&tmp, rawData);
-*     timeFlag = false;
-* ```
-* @todo Find a more elegant way to do this!
-*/
-bool timeFlag = true;
+#include "Instrument.h"
 
 /*
 * @note
@@ -27,7 +13,15 @@ bool timeFlag = true;
 */
 String _prefix = "";
 
-Database::Database(): CQueue() {} //< Constructor
+// Any non-zero state, until begin() seeds the keystream
+#define KEY_STATE_INIT               2463534242UL
+
+Database::Database(): CardQueue(), _index(_database.getQueueData()),
+                      _seen(_database.getQueueData()), _numArrivals(0),
+                      _journal(NULL), _isCheckpointDue(false), _snapshotSlot(0),
+                      _encoding(TOKEN_DECIMAL), _hasCheck(false),
+                      _callback(NULL), _context(NULL), _isArrivalLost(false),
+                      _keyState(KEY_STATE_INIT) {} //< Constructor
 
 /**
 * @public
@@ -38,121 +32,375 @@ void Database::begin()
     // [WARNING] IMPORTANT
     // seed for random number, used in hashing TID.
     randomSeed(analogRead(ANALOG_PIN));
+
+    // Seed of the keys of the tokens (see _drawKey()), must not be 0
+    _keyState = (uint32_t)random() ^ micros();
+    if (_keyState == 0)
+        _keyState = KEY_STATE_INIT;
+}
+/**
+* @public
+* @brief Store cards to the permanent database
+*/
+Status Database::updateDB(byte* rawData)
+{
+    return updateDB(InventoryFrame(rawData));
 }
+
 /**
 * @public
-* @brief Store inventoried cards to database
+* @brief Store the cards of a checked response frame to the permanent database
 */
-Status Database::inventoryCards(CQueue* inventoryDB, byte* rawData)
-{
-    // Get number of cards in the effective field
-    byte numCards = rawData[RE_INV_NUM_CARDS_INDEX];
-    
-    if ((rawData[RE_STATUS_INDEX] == STATUS_SUCCESS) 
-        && (numCards > MAX_CARDS)) {
-        return ERR_NUM_CARDS;
+Status Database::updateDB(const InventoryFrame& frame)
+{
+    if (frame.getStatus() != STATUS_SUCCESS)
+        return frame.getStatus();
+
+    UHF_SPAN(STAGE_UPDATE);
+    uint32_t now = millis(); //< Sample the clock once per frame
+
+    // Disconnect expired cards first, an expired card which is inventoried
+    // again is stored as a new card (`.status = false`).
+    sweepExpired(now);
+
+    for (InventoryFrame::Iterator it = frame.begin(); it != frame.end(); ++it) {
+        TidKey key = it.getKey();
+        if (_seen.isRepeat(key))
+            continue;
+        CardIndex j = _store(key, now);
+        if (j != _index.NONE)
+            _seen.insert(key, j);
     }
-        
-    if (rawData[RE_STATUS_INDEX] != STATUS_SUCCESS)
-        return rawData[RE_STATUS_INDEX];
-    
-    Card tmp[MAX_CARDS] = {0};
-
-    byte sizeIndex = RE_INV_TID_SIZE_INDEX;
-    for (byte i = 0; i < numCards; i++) {
-        tmp[i].tid.size = rawData[sizeIndex]; //< get TID size
-
-        tmp[i].status = false;
-        
-        // Get TID from inventory command respond frame 
-        for (size_t j = 0; j < tmp[i].tid.size; j++) {
-            tmp[i].tid.tidByte[j] = rawData[j + sizeIndex + 1];
-        }
 
-        // A timeFlag is added to make sure the timestamp is set once for 
-        // each card.
-        if (timeFlag) {  
-            tmp[i].time = millis();
-        }
+    // The last frame of the session
+    if (!frame.isContinued())
+        _seen.clear();
 
-        if (inventoryDB->isFull())
-            inventoryDB->dequeue();
+    return STATUS_SUCCESS;
+}
 
-        inventoryDB->enqueue(tmp[i]);
+/**
+* @private
+* @brief Store one inventoried card
+*/
+CardIndex Database::_store(const TidKey key, const uint32_t now)
+{
+    Card* cards = _database.getQueueData();
+    CardIndex j = _index.find(key);
+
+    if (j != _index.NONE) { //< if match
+        cards[j].time = now; //< Update time stamp
+        _expiry.touch(j);
+        _emit(CARD_REFRESHED, j, key, now);
+        return j;
+    }
 
-        /**
-        * Update new index of TID size
-        * New index = previous TID size + 1
-        */
-        sizeIndex += rawData[sizeIndex] + 1;
+    Card newCard;
+    newCard.status = false;
+    unpackTid(key, newCard.tid);
+    newCard.time = now;
+
+    // if there is no card that match, overwrite the new card to the slot
+    // of an expired card
+    j = _expiry.acquire();
+
+    // If there is no expired cards, then enqueue card to the end of 
+    // the queue
+    if (j == _expiry.NONE) {
+        if (_database.enqueue(newCard) != STATUS_SUCCESS)
+            return _index.NONE; //< The database is full of live cards
+        j = _database.getTailSlot();
+    } else {
+        cards[j] = newCard;
     }
-    return STATUS_SUCCESS;
+
+    _index.insert(j);
+    _expiry.touch(j);
+    _drawKey(_keys[j]); //< The token of the card is fixed from now on
+    _numArrivals++;
+
+    if (_arrivals.enqueue(j) != STATUS_SUCCESS)
+        _isArrivalLost = true;
+    _emit(CARD_ARRIVED, j, key, now);
+    return j;
+}
+
+/**
+* @private
+* @brief Report an event of a card to the callback, if any
+*/
+void Database::_emit(const CardEventType type, const CardIndex slot,
+                     const TidKey key, const uint32_t now)
+{
+    if (_callback == NULL)
+        return;
+
+    CardEvent event;
+    event.type = type;
+    event.slot = slot;
+    event.key = key;
+    event.time = now;
+    _callback(event, _context);
+}
+
+/**
+* @private
+* @brief Draw the random bytes of the token of a new card
+*/
+void Database::_drawKey(byte* key)
+{
+    // xorshift32: one step gives the bytes of a key
+    uint32_t x = _keyState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _keyState = x;
+
+    // Same range as random(1, 255): a key of 0 would leave TID bytes clear
+    for (byte i = 0; i < HASH_KEY_SIZE; i++)
+        key[i] = 1 + (((uint16_t)(byte)(x >> (8 * i)) * 254) >> 8);
 }
 
 /**
 * @public
-* @brief Store cards to the permanent database
+* @brief Start an inventory session
 */
-Status Database::updateDB(byte* rawData)
+void Database::beginSession()
 {
-    CQueue tmp; //< temporary database to store inventoried cards in the 
-                //  current session
+    _seen.clear();
+}
 
-    timeFlag = true;
-    Status status = inventoryCards(&tmp, rawData);
-    timeFlag = false;
+/**
+* @public
+* @brief Disconnect expired cards
+*/
+CardIndex Database::sweepExpired(const uint32_t now)
+{
+    Card* cards = _database.getQueueData();
+    CardIndex numExpired = 0;
+    CardIndex q = _expiry.getOldest();
+
+    // Cards are ordered by the time they were last seen, stop at the first 
+    // card which is not expired.
+    while ((q != _expiry.NONE) && ((now - cards[q].time) >= EXPIRE_TIME)) {
+        TidKey key = packTid(cards[q].tid);
+        if (cards[q].status)
+            _log(JOURNAL_EXPIRED, key, now);
+        _index.remove(q);
+        _expiry.release(q);
+        _emit(CARD_LEFT, q, key, now);
+        numExpired++;
+        q = _expiry.getOldest();
+    }
 
+    // A TID of the session may refer to a disconnected card
+    if (numExpired > 0)
+        _seen.clear();
+    return numExpired;
+}
+
+/**
+* @public
+* @brief Restore the typed cards after a reset (warm restart)
+*/
+Status Database::restore(DatabaseJournal& journal)
+{
+    Status status = journal.begin();
     if (status != STATUS_SUCCESS)
         return status;
 
-    // Compare the temporary database (current inventory session) with the 
-    // permanent database.
-    for (byte i = 0; i < tmp.getSize(); i++) { //< Temporary databse
-        String newTid = toString(tmp.getQueueData()[i].tid);
-        byte j = 0;
-        
-        for (j = 0; j < _database.getCapacity(); j++) { //< Permanent one
-            String tmpTid = toString(_database.getQueueData()[j].tid);
-
-            if (tmpTid == newTid) { //< if match
-                // Disconnect expired cards - by setting `.status = false` 
-                if ((millis() - _database.getQueueData()[j].time) >= EXPIRE_TIME) {
-                    _database.getQueueData()[j].status = false;
-                }
-
-                _database.getQueueData()[j].time = millis(); //< Update time stamp
-                break; 
+    // Restored cards are neither arrivals nor events
+    uint32_t numArrivals = _numArrivals;
+    EventCallback callback = _callback;
+    _callback = NULL;
+    journal.replay(_restoreRecord, this);
+    _numArrivals = numArrivals;
+    _callback = callback;
+    _seen.clear(); //< Slots of replayed cards may have been released
+
+    // Start a new generation, the old journal may end with a torn record
+    _journal = &journal;
+    _isCheckpointDue = false;
+    return checkpoint();
+}
+
+/**
+* @public
+* @brief Set the function called for every event of a card
+*/
+void Database::setEventCallback(EventCallback callback, void* context)
+{
+    _callback = callback;
+    _context = context;
+}
+
+/**
+* @public
+* @brief Write the changes to the journal, a few bytes at a time
+*/
+Status Database::sync(const uint32_t now)
+{
+    if (_journal == NULL)
+        return STATUS_SUCCESS;
+
+    _logTyped(now);
+    size_t room = JOURNAL_SYNC_BYTES;
+    while (room > 0) {
+        if (!_journal->isBusy()) {
+            if (_isCheckpointDue) {
+                _beginCheckpoint();
+            } else if (!_journal->isDue(now)) {
+                break;
+            } else if (_journal->beginFlush() == ERR_QUEUE_FULL) {
+                _isCheckpointDue = true; //< The snapshot has the changes of the batch
+                continue;
             }
         }
+        room -= _writeJournal(room);
+    }
+    return STATUS_SUCCESS;
+}
 
-        // if there is no card that match
-        if (j == _database.getCapacity()) {
-            byte q = 0;
+/**
+* @public
+* @brief Write a snapshot of the typed cards to the journal
+*/
+Status Database::checkpoint()
+{
+    if (_journal == NULL)
+        return STATUS_ERROR;
+
+    // Finish the operation being written, then write a whole snapshot
+    _logTyped(millis());
+    while (_journal->isBusy())
+        _writeJournal(SIZE_MAX);
+    _beginCheckpoint();
+    while (_journal->isBusy())
+        _writeJournal(SIZE_MAX);
+    return STATUS_SUCCESS;
+}
 
-            // Iterate to overwrite new cards to expired cards
-            for (q = 0; q < _database.getSize(); q++) {
-                if ((millis() - _database.getQueueData()[q].time) >= EXPIRE_TIME) {
-                    _database.getQueueData()[q] = tmp.getQueueData()[i];
-                    break;
-                }
-            }
+/**
+* @private
+* @brief Record a change of a card to the journal, if any
+*/
+void Database::_log(const JournalOp op, const TidKey key, const uint32_t now)
+{
+    if (_journal == NULL)
+        return;
 
-            // If there is no expired cards, then enqueue card to the end of 
-            // the queue
-            if (q == _database.getSize()) {
-                _database.enqueue(tmp.getQueueData()[i]);
-            }
+    // Never write from here: a full batch is recorded by the next snapshot
+    if (_journal->append(op, key, now) != STATUS_SUCCESS)
+        _isCheckpointDue = true;
+}
+
+/**
+* @private
+* @brief Record the cards whose tokens have been typed to the journal
+*/
+void Database::_logTyped(const uint32_t now)
+{
+    uint16_t numTyped = _keyboard.getNumTyped();
+    while (!_typing.isEmpty()) {
+        TypedToken& typed = _typing.front();
+        if ((int16_t)(numTyped - typed.token) <= 0)
+            return; //< Tokens are typed in order
+
+        // The card may have left while its token was being typed
+        if (_index.find(typed.key) == typed.slot)
+            _log(JOURNAL_PRINTED, typed.key, now);
+        _typing.dequeue();
+    }
+}
+
+/**
+* @private
+* @brief Return true if the token of a card is queued but not typed yet
+*/
+bool Database::_isTyping(const CardIndex slot)
+{
+    TidKey key = packTid(_database.getQueueData()[slot].tid);
+    for (TypedTokenQueue::Iterator it = _typing.begin(); it != _typing.end(); ++it) {
+        if ((it->slot == slot) && (it->key == key))
+            return true;
+    }
+    return false;
+}
+
+/**
+* @private
+* @brief Start writing a snapshot of the typed cards (see _writeJournal())
+*/
+void Database::_beginCheckpoint()
+{
+    _journal->beginSnapshot();
+    _snapshotSlot = 0;
+    _isCheckpointDue = false;
+}
+
+/**
+* @private
+* @brief Write at most `maxBytes` bytes of the journal
+*/
+size_t Database::_writeJournal(const size_t maxBytes)
+{
+    // Add the typed cards of the next slots, as many as can be buffered.
+    // Cards which change meanwhile are also recorded to the journal of the
+    // snapshot.
+    if (_journal->isSnapshotOpen()) {
+        Card* cards = _database.getQueueData();
+        CardIndex size = _database.getSize();
+        while ((_snapshotSlot < size) && _journal->canAddSnapshot()) {
+            if (cards[_snapshotSlot].status && _expiry.isLive(_snapshotSlot)
+                && !_isTyping(_snapshotSlot))
+                _journal->addSnapshot(packTid(cards[_snapshotSlot].tid));
+            _snapshotSlot++;
         }
-    }    
+        if (_snapshotSlot >= size)
+            _journal->commitSnapshot();
+    }
 
-    return STATUS_SUCCESS;
+    return _journal->write(maxBytes);
+}
+
+/**
+* @private
+* @brief Apply a card or record replayed by restore()
+*/
+void Database::_restoreRecord(JournalOp op, TidKey key, void* context)
+{
+    Database* database = (Database*)context;
+    Card* cards = database->_database.getQueueData();
+
+    if (op == JOURNAL_PRINTED) {
+        CardIndex j = database->_store(key, millis());
+        if (j != database->_index.NONE)
+            cards[j].status = true;
+        return;
+    }
+
+    // JOURNAL_EXPIRED: disconnect the card
+    CardIndex j = database->_index.find(key);
+    if (j != database->_index.NONE) {
+        database->_index.remove(j);
+        database->_expiry.release(j);
+    }
+}
+
+/**
+* @public
+* @brief Get number of cards which arrived
+*/
+uint32_t Database::getNumArrivals()
+{
+    return _numArrivals;
 }
 
 /**
 * @public
 * @brief Get cards' database
 */
-CQueue& Database::getDB()
+CardQueue& Database::getDB()
 {
     return _database;
 }
@@ -163,15 +411,99 @@ CQueue& Database::getDB()
 */
 void Database::printToKeyboard()
 {
-    // Pass prtCardKeyboard() to CQueue::_debugPrint()`
-    _database._debugPrint(prtCardKeyBoard);
+    UHF_SPAN(STAGE_KEYBOARD);
+    // Tokens are formatted on the stack, a longer token could not be queued
+    char token[KEYBOARD_BUFFER_SIZE];
+    TextBuffer text(token, sizeof(token));
+    Card* cards = _database.getQueueData();
+    if (_journal != NULL)
+        _logTyped(millis());
+
+    // Some arrivals were not queued: queue every new card again
+    if (_isArrivalLost) {
+        _arrivals.clear();
+        for (CardQueue::Iterator it = _database.begin(); it != _database.end(); ++it) {
+            if (!it->status && _expiry.isLive(it.getSlot()))
+                _arrivals.enqueue(it.getSlot());
+        }
+        _isArrivalLost = false;
+    }
+
+    while (!_arrivals.isEmpty()) {
+        CardIndex j = _arrivals.front();
+
+        // The card may have been printed elsewhere, or may have left
+        if (!cards[j].status && _expiry.isLive(j)) {
+            text.clear();
+            printToken(text, cards[j]);
+
+            // Keep the card queued if the output buffer is full, it will be
+            // queued to the keyboard next time.
+            uint16_t numQueued = _keyboard.getNumQueued();
+            if (text.isOverflowed() || ((_journal != NULL) && _typing.isFull())
+                || (_keyboard.enqueue(token) != STATUS_SUCCESS)) {
+                UHF_SPAN_STATUS(ERR_QUEUE_FULL);
+                return;
+            }
+
+            // The journal records the card once its token is typed
+            cards[j].status = true;
+            if (_journal != NULL) {
+                TypedToken typed = {packTid(cards[j].tid), numQueued, j};
+                _typing.enqueue(typed);
+            }
+        }
+        _arrivals.dequeue();
+    }
+}
+
+/**
+* @public
+* @brief Print the token of a card of the database
+*/
+void Database::printToken(Print& out, const Card& card)
+{
+    ::printHash(out, card.tid, _keys[&card - _database.getQueueData()],
+                _prefix.c_str(), _encoding, _hasCheck);
+}
+
+/**
+* @public
+* @brief Set the encoding of the tokens typed by printToKeyboard()
+*/
+void Database::setEncoding(const TokenEncoding encoding, const bool hasCheck)
+{
+    _encoding = encoding;
+    _hasCheck = hasCheck;
+}
+
+/**
+* @public
+* @brief Mark a card as typed (`.status = true`)
+*/
+void Database::markPrinted(Card& card)
+{
+    card.status = true;
+
+    // The slots of expired cards are not restored
+    if (_expiry.isLive(&card - _database.getQueueData()))
+        _log(JOURNAL_PRINTED, packTid(card.tid), millis());
+}
+
+/**
+* @public
+* @brief Get the keyboard output scheduler
+*/
+KeyboardScheduler& Database::getKeyboard()
+{
+    return _keyboard;
 }
 
 /**
 * @public or @protected
 * @brief Debug function - print the whole database
 */
-void Database::_debugPrintDB(CQueue& database)
+void Database::_debugPrintDB(CardQueue& database)
 {
    Serial.println("TID\t\t\tStatus\t\tTime");
    // Pass prtCardInfo() to CQueue::_debugPrint()`
@@ -197,44 +529,118 @@ void _setPrefix(const String prefix)
 /* @brief Convert TID to string */
 String toString(TID& tid)
 {
-    String strTid;
+    char buffer[3 * MAX_SIZE_TID + 1];
+    TextBuffer text(buffer, sizeof(buffer));
+    printTid(text, packTid(tid));
+    return String(buffer);
+}
+
+
+/* @brief Hash generation */
+const String generateHash(TID tid, const String prefix,
+                          const TokenEncoding encoding, const bool hasCheck)
+{
+    char buffer[3 * (MAX_SIZE_TID + HASH_KEY_SIZE) + 2];
+    TextBuffer text(buffer, sizeof(buffer));
+    printHash(text, tid, "", encoding, hasCheck);
+    return prefix + String(buffer);
+}
 
-    for (size_t i = 0; i < tid.size; i++) {
-        byte tmp = tid.tidByte[i];
+// Crockford's base 32 digits, then the 5 extra check symbols
+static const char CROCKFORD_DIGITS[] PROGMEM = "0123456789ABCDEFGHJKMNPQRSTVWXYZ*~$=U";
 
-        // Add leading 0s to make sure every byte has 3 digits 
-        if (tmp < 100) strTid += "0";
-        if (tmp < 10) strTid += "0";
+/* Print bytes with 5 bits per character (Crockford's base 32) */
+static void printBase32(Print& out, const byte* data, const byte size)
+{
+    char digits[(8 * (MAX_SIZE_TID + HASH_KEY_SIZE) + 4) / 5];
+    byte numDigits = 0;
+    uint16_t bits = 0; //< Bits not printed yet, in the low `numBits` bits
+    byte numBits = 0;
+
+    for (byte i = 0; i < size; i++) {
+        bits = (bits << 8) | data[i];
+        numBits += 8;
+        while (numBits >= 5) {
+            numBits -= 5;
+            digits[numDigits++] = pgm_read_byte(CROCKFORD_DIGITS + ((bits >> numBits) & 0x1F));
+        }
+    }
+    if (numBits > 0) //< Pad the last character with 0 bits
+        digits[numDigits++] = pgm_read_byte(CROCKFORD_DIGITS + ((bits << (5 - numBits)) & 0x1F));
 
-        strTid += String(tmp, DEC);
+    out.write(digits, numDigits);
+}
+
+/* Print bytes with 2 hexadecimal digits per byte */
+static void printHex(Print& out, const byte* data, const byte size)
+{
+    char digits[2 * (MAX_SIZE_TID + HASH_KEY_SIZE)];
+    for (byte i = 0; i < size; i++) {
+        digits[2 * i] = pgm_read_byte(CROCKFORD_DIGITS + (data[i] >> 4));
+        digits[2 * i + 1] = pgm_read_byte(CROCKFORD_DIGITS + (data[i] & 0x0F));
     }
-    return strTid;
+    out.write(digits, 2 * size);
 }
 
+/* Crockford's check symbol: the bytes as a big-endian number, modulo 37 */
+static char getCheckSymbol(const byte* data, const byte size)
+{
+    byte remainder = 0;
+    for (byte i = 0; i < size; i++)
+        remainder = ((uint16_t)remainder * 256 + data[i]) % 37;
+    return pgm_read_byte(CROCKFORD_DIGITS + remainder);
+}
 
-/* @brief Hash generation */
-const String generateHash(TID tid, const String prefix) 
+/* Print a byte with 3 decimal digits (leading 0s) */
+static void printByte(Print& out, const byte value)
+{
+    char digits[3] = { (char)('0' + value / 100), (char)('0' + (value / 10) % 10),
+                       (char)('0' + value % 10) };
+    out.write(digits, sizeof(digits));
+}
+
+/* @brief Print a TID (3 decimal digits per byte, same as toString()) */
+void printTid(Print& out, const TidKey key)
+{
+    for (byte i = 0; i < getTidSize(key); i++)
+        printByte(out, (byte)(key >> (56 - 8 * i)));
+}
+
+/* @brief Print the hash of a TID (same as generateHash()) */
+void printHash(Print& out, TID tid, const char* prefix,
+               const TokenEncoding encoding, const bool hasCheck)
 {
-    String strTid;
-    byte n = 2;
-    byte key[n];
-    for (byte i = 0; i < n; i++) {
+    byte key[HASH_KEY_SIZE];
+    for (byte i = 0; i < HASH_KEY_SIZE; i++) {
         key[i] = random(1, 255);
     }
-    
-    for (byte i = 0; i < tid.size; i++) {
-        tid.tidByte[i] ^= key[i % n]; 
-    }
-    
-    strTid = toString(tid);
+    printHash(out, tid, key, prefix, encoding, hasCheck);
+}
 
-    for (byte i = 0; i < n; i++) {
-        if (key[i] < 100) strTid += "0";
-        if (key[i] < 10) strTid += "0";
-        strTid += String(key[i], DEC);
+/* @brief Print the hash of a TID with given random bytes */
+void printHash(Print& out, const TID& tid, const byte* key, const char* prefix,
+               const TokenEncoding encoding, const bool hasCheck)
+{
+    // Bytes of the hash: the TID XOR the keys, then the keys
+    byte data[MAX_SIZE_TID + HASH_KEY_SIZE];
+    byte size = 0;
+    for (byte i = 0; i < tid.size; i++)
+        data[size++] = tid.tidByte[i] ^ key[i % HASH_KEY_SIZE];
+    for (byte i = 0; i < HASH_KEY_SIZE; i++)
+        data[size++] = key[i];
+
+    out.print(prefix);
+    if (encoding == TOKEN_HEX) {
+        printHex(out, data, size);
+    } else if (encoding == TOKEN_BASE32) {
+        printBase32(out, data, size);
+    } else {
+        for (byte i = 0; i < size; i++)
+            printByte(out, data[i]);
     }
 
-    return prefix + strTid;
+    if (hasCheck)
+        out.write(getCheckSymbol(data, size));
 }
 
 /*
@@ -245,32 +651,38 @@ const String generateHash(TID tid, const String prefix)
 /* Print card information: TID, status, time. */
 void prtCardInfo(Card* card)
 {
-    String tid = toString(card->tid);
-    Serial.print(tid);
-    Serial.print("\t");
-    Serial.print(card->status);
-    Serial.print("\t\t");
-    Serial.println(card->time);
+    char line[DEBUG_LINE_SIZE];
+    TextBuffer text(line, sizeof(line));
+    printTid(text, packTid(card->tid));
+    text.print("\t");
+    text.print(card->status);
+    text.print("\t\t");
+    text.println(card->time);
+    Serial.write(text.c_str(), text.length()); //< One write per line
 }
 
 /* Print welcome message  - for testing card.status */
 void prtCardMsg(Card* card)
 {
     if (card->status == false) {
-        Serial.print("Hello ");
-        Serial.print(toString(card->tid));
-        Serial.print(". You are in at ");
-        Serial.print(card->time);
-        Serial.println(". ");
+        char line[DEBUG_LINE_SIZE];
+        TextBuffer text(line, sizeof(line));
+        text.print("Hello ");
+        printTid(text, packTid(card->tid));
+        text.print(". You are in at ");
+        text.print(card->time);
+        text.println(". ");
+        Serial.write(text.c_str(), text.length()); //< One write per line
         card->status = true;
     }
 }
 
-/* Print hased TID to keyboard */
+/* Print hased TID to keyboard (blocking, see Database::printToKeyboard()) */
 void prtCardKeyBoard(Card* card)
 {
     if (card->status == false) {
-        Keyboard.println(generateHash(card->tid, _prefix));
+        printHash(Keyboard, card->tid, _prefix.c_str());
+        Keyboard.println();
         card->status = true;
         delay(800); //< Modify this delay() to change delay time between cards
                     //  if there are multiple cards are tapped at once 
@@ -5,22 +5,14 @@
 #include <stdint.h>
 
 #include "CQueue.h"
-
-/*
-* @note
-* - `timeFlag` is used to ensure that timestamps are set once only for each 
-* inventoried card
-* - Make sure every time calling inventoryCards(), a timeFlag is wrapped 
-* around (see the example below) 
-* @example: 
-* ```
-*     timeFlag = true;
-*     Status status = inventoryCards(&tmp, rawData);
-*     timeFlag = false;
-* ```
-* @todo Find a more elegant way to do this!
-*/
-extern bool timeFlag;
+#include "DatabaseJournal.h"
+#include "ExpiryList.h"
+#include "InventoryFrame.h"
+#include "KeyboardScheduler.h"
+#include "SessionFilter.h"
+#include "TextBuffer.h"
+#include "TidIndex.h"
+#include "TidKey.h"
 
 /*
 * @note
@@ -33,15 +25,69 @@ extern bool timeFlag;
 */
 extern String _prefix;
 
-class Database: public CQueue //< Inheritance from CQueue
+/*
+* Encodings of the hashed TIDs typed to the keyboard (see printHash()). The
+* bytes of a hash (6 bytes of TID and 2 random bytes) are typed as:
+* - TOKEN_DECIMAL: 3 decimal digits per byte (24 keystrokes), the original
+*   format.
+* - TOKEN_HEX: 2 upper-case hexadecimal digits per byte (16 keystrokes).
+* - TOKEN_BASE32: Crockford's base 32 (`0-9A-Z` without `ILOU`), 5 bits per
+*   character, most significant bit first, the last character padded with 0
+*   bits (13 keystrokes). Case-insensitive, so Caps Lock does not matter.
+* A check character (Crockford's: the bytes as a big-endian number, modulo
+* 37, from `0-9A-Z` without `ILOU`, then `*~$=U`) can be appended to any of
+* them, to detect mistyped tokens.
+*/
+enum TokenEncoding: byte {
+    TOKEN_DECIMAL      = 0,
+    TOKEN_HEX          = 1,
+    TOKEN_BASE32       = 2
+};
+
+/*
+* Events of the cards of a database (see Database::setEventCallback()).
+*/
+enum CardEventType: byte {
+    CARD_ARRIVED       = 1, //< New card (or expired card inventoried again)
+    CARD_REFRESHED     = 2, //< Known card inventoried again
+    CARD_LEFT          = 3  //< Card not seen for `EXPIRE_TIME`, disconnected
+};
+
+/* Event of a card */
+typedef struct {
+    CardEventType type;
+    CardIndex slot; //< Slot of the card in the database (see getDB())
+    TidKey key; //< Packed TID of the card
+    uint32_t time; //< `millis()` of the inventory session (or of the sweep)
+} CardEvent;
+
+// Number of random bytes of a hash (see printHash())
+#define HASH_KEY_SIZE                2
+
+/* Queue of cards, used for the database and inventory sessions */
+typedef CQueue<Card, DATABASE_CAPACITY, CardIndex> CardQueue;
+
+class Database: public CardQueue //< Inheritance from CQueue
 {
 public:
+    /**
+    * @brief Called for every event of a card
+    * @detail Called from updateDB() and sweepExpired(), while the database
+    * is being updated: do not update the database from the callback, except
+    * markPrinted(). The card is still in its slot, even if it has left.
+    * @param
+    * - event: what happened, to which card, when.
+    * - context: pointer given to setEventCallback().
+    */
+    typedef void (*EventCallback)(const CardEvent& event, void* context);
+
     Database(); //< Default constructor
     
     /**
     * @brief Initialise Database
     * @detail This function is REALLY IMPORTANT as it seeds value for random(),
-    * used for hashing TIDs (algorithm used by Tictag JSC).
+    * used for hashing TIDs (algorithm used by Tictag JSC), and the keystream
+    * of the tokens of the database (see printToken()).
     *
 	* @param none
     *
@@ -49,34 +95,23 @@ public:
 	*/
     void begin();
 
-    /**
-    * @brief Store inventoried cards to database
-    * @detail Raw data from inventory command are processed and enqueue to queue.
-    *
-    * @param
-    * - inventoryDB: a temporary database used for storing cards every inventory
-    * session.
-    * - rawData: array of bytes got from inventory command.
-    *
-	* @return
-	* - STATUS_SUCCESS: inventory cards to database successfully.
-	* - ERR_NUM_CARDS: number of cards read from inventory command are larger.
-	*   than a pre-defined maximum number of cards can be read at once.
-	* - For other values returned from this functions, see `doc/Protocols`.
-	*/
-    Status inventoryCards(CQueue* inventoryDB, byte* rawData);
-
     /**
     * @brief Store cards to the permanent database
     * @detail This func compares if the inventoried cards and cards existed in
-    * the database are matched.
-    * - In case of matching, keep checking which cards are expired by comparing
-    * with `EXPIRE_TIME` (see `attribute.h`) and set their status to false 
-    * (ready to be printed again - or ready to be re-connected).
-    * - In case of not matching, the queue will be iterated to find which cards
-    * are expired, then the expired cards will be overwritten by the new cards.
+    * the database are matched (using the TID hash index, see `TidIndex.h`).
+    * TIDs are read in place from `rawData` (see `InventoryFrame.h`), there is
+    * no temporary queue of cards.
+    * - First, cards which are not seen for `EXPIRE_TIME` (see `attribute.h`)
+    * are disconnected (see sweepExpired()). Therefore, an expired card which
+    * is inventoried again is stored as a new card with status false (ready to
+    * be printed again - or ready to be re-connected).
+    * - A TID repeated in the frame (or in the previous frames of the session)
+    * is dropped (see `SessionFilter.h`).
+    * - In case of matching, the timestamp of the card is updated.
+    * - In case of not matching, the new cards overwrite expired cards.
     * - In case of not matching, but there is no expired card, the new cards 
     * will be enqueued to the end of the queue.
+    * `millis()` is sampled once per call.
     *
     * @param
     * - rawData: bytes of data from inventory command (new inventory session).
@@ -85,24 +120,201 @@ public:
 	* - STATUS_SUCCESS: add cards to the database successfully.
 	* - ERR_NUM_CARDS: number of cards read from inventory command are larger
 	* than a pre-defined maximum number of cards can be read at once.
+	* - ERR_TID_SIZE: a TID is larger than `MAX_SIZE_TID`, or runs past the
+	* CRC of the frame. No card of the frame is stored.
 	* - For other values returned from this functions, see `doc/Protocols`.
 	*/
     Status updateDB(byte* rawData);
-    
+
+    /**
+    * @brief Store the cards of a checked response frame to the permanent 
+    * database
+    * @detail Same as updateDB(byte*), e.g. for the frames of a multi-frame
+    * inventory session (see `InventorySession`). TIDs are filtered from the
+    * first frame of a session (after beginSession(), or after a frame whose
+    * status is not `ERR_INV_FRAME_OUT`) to its last frame.
+    *
+    * @param
+    * - frame: view of a response frame.
+    *
+    * @return see `InventoryFrame::getStatus()`
+    */
+    Status updateDB(const InventoryFrame& frame);
+
+    /**
+    * @brief Start an inventory session
+    * @detail Forget the TIDs of the previous session (see
+    * `SessionFilter.h`), e.g. if it was aborted before its last frame.
+    * `InventorySession` calls it when a session starts.
+    * @param none
+    * @return none
+    */
+    void beginSession();
+
+    /**
+    * @brief Disconnect expired cards
+    * @detail Cards which are not seen for `EXPIRE_TIME` are removed from the
+    * TID index, their slots are reused by the next new cards. Only expired 
+    * cards are visited (see `ExpiryList.h`), so it is cheap to call this 
+    * function from `loop()` even when there is no inventory session.
+    *
+    * @param
+    * - now: current time (`millis()`).
+    *
+    * @return number of disconnected cards
+    */
+    CardIndex sweepExpired(const uint32_t now);
+
+    /**
+    * @brief Set the function called for every event of a card
+    * @detail Cards which arrive or leave are reported as they happen, so
+    * the work of a consumer is proportional to the changes, not to the
+    * capacity of the database. Cards loaded by restore() are not reported.
+    *
+    * @example
+    * ```
+    *     void onCard(const CardEvent& event, void* context)
+    *     {
+    *         if (event.type == CARD_ARRIVED)
+    *             printTid(Serial, event.key);
+    *     }
+    *     ...
+    *     database->setEventCallback(onCard, NULL);
+    * ```
+    *
+    * @param
+    * - callback: see `EventCallback`, NULL for none (default).
+    * - context: passed to every call of `callback`.
+    * @return none
+    */
+    void setEventCallback(EventCallback callback, void* context);
+
+    /**
+    * @brief Restore the typed cards after a reset (warm restart)
+    * @detail Cards which were typed to the keyboard and still connected when
+    * the MCU was reset are loaded from the journal (see `DatabaseJournal.h`)
+    * with status true and the current time, so they are not typed again if
+    * they are still in the field. They are not counted as arrivals. Then a
+    * snapshot is written and the journal records every change from now on.
+    * Call it in `setup()`, after begin().
+    *
+    * @param
+    * - journal: journal of the database, kept until the end.
+    *
+    * @return
+    * - STATUS_SUCCESS: the cards are restored.
+    * - STATUS_ERROR: the storage of the journal is too small.
+    */
+    Status restore(DatabaseJournal& journal);
+
+    /**
+    * @brief Write the changes to the journal, a few bytes at a time
+    * @detail Call this function from `loop()`, it writes at most
+    * `JOURNAL_SYNC_BYTES` bytes and resumes there next time. Changes wait in
+    * RAM until `JOURNAL_BATCH` changes are batched or for
+    * `JOURNAL_FLUSH_PERIOD` ms, so the storage (e.g. EEPROM) is written
+    * seldom. A snapshot is written when the journal or the batch is full.
+    * Nothing else writes to the storage while cards are processed.
+    *
+    * @param
+    * - now: current time (`millis()`).
+    *
+    * @return
+    * - STATUS_SUCCESS: always.
+    */
+    Status sync(const uint32_t now);
+
+    /**
+    * @brief Write a snapshot of the typed cards to the journal
+    * @detail Blocks until the snapshot is written (e.g. before a shutdown),
+    * sync() writes it in small steps instead.
+    * @param none
+    * @return
+    * - STATUS_SUCCESS: the snapshot is written.
+    * - STATUS_ERROR: there is no journal (see restore()).
+    */
+    Status checkpoint();
+
+    /**
+    * @brief Get number of cards which arrived
+    * @detail Counts every new card stored to the database (including expired
+    * cards which are inventoried again) since the database was created. The 
+    * difference of 2 calls is the number of arrivals in between (e.g. see
+    * `PollController`).
+    * @param none
+    * @return number of arrivals (wraps around)
+    */
+    uint32_t getNumArrivals();
+
     /**
     * @brief Get cards' database
     * @param none
     * @return reference to `_database`.s
     */
-    CQueue& getDB();
+    CardQueue& getDB();
 
     /**
     * @brief Print hashed TIDs to keyboard (for web dev team)s
+    * @detail Hashed TIDs of new cards are queued to the keyboard scheduler,
+    * this function does not block. Tokens are formatted on the stack (see
+    * printToken()), nothing is allocated. Call `getKeyboard().run()` in every
+    * `loop()` to type them.
+    * Only the cards which arrived since the last call are visited, in order
+    * of arrival (the whole database is visited again if more cards arrived
+    * than the database can hold).
+    * With a journal (see restore()), a card is recorded as typed only once
+    * its token has been typed, so the tokens lost by a reset are typed
+    * again. Up to `KEYBOARD_BUFFER_SIZE / 16` tokens wait to be typed.
     * @param none
     * @return none
     */
     void printToKeyboard();
 
+    /**
+    * @brief Print the token of a card of the database
+    * @detail The random bytes of the token are drawn once, when the card
+    * arrives (from a xorshift keystream seeded by begin()), so a card has
+    * the same token every time it is printed, until it expires. Formatting
+    * is the only work left: the prefix (see `_setPrefix()`), the encoding
+    * and the check character (see setEncoding()).
+    * @param
+    * - out: output (e.g. `Keyboard`, `TextBuffer`).
+    * - card: card of the database (see getDB()).
+    * @return none
+    */
+    void printToken(Print& out, const Card& card);
+
+    /**
+    * @brief Set the encoding of the tokens typed by printToKeyboard()
+    * @param
+    * - encoding: see `TokenEncoding` (default: `TOKEN_DECIMAL`).
+    * - hasCheck: true to append a check character (default: false).
+    * @return none
+    */
+    void setEncoding(const TokenEncoding encoding, const bool hasCheck);
+
+    /**
+    * @brief Mark a card as typed (`.status = true`)
+    * @detail The change is recorded by the journal, if any (see restore()),
+    * unless the card has expired.
+    * printToKeyboard() marks the cards it queues, and records them once the
+    * keyboard has typed them. Call this function for cards printed
+    * elsewhere, once they are printed.
+    * @param
+    * - card: card of the database (see getDB()).
+    * @return none
+    */
+    void markPrinted(Card& card);
+
+    /**
+    * @brief Get the keyboard output scheduler
+    * @detail e.g. to type the queued tokens (run()) or to set the pacing of 
+    * keystrokes (setPacing()).
+    * @param none
+    * @return reference to the keyboard scheduler
+    */
+    KeyboardScheduler& getKeyboard();
+
 /*
 * These functions are intended to be protected - uncomment `// protected: `
 * to protect them
@@ -114,7 +326,7 @@ public:
     * - database: reference to the database needs to be printed.
     * @return none
     */
-    void _debugPrintDB(CQueue& database);
+    void _debugPrintDB(CardQueue& database);
 
     /**
     * @brief Debug function - print welcome message
@@ -125,7 +337,73 @@ public:
     void _debugPrintDBMsg();
 
 private:
-    CQueue _database; //< database stored cards
+    /* Token queued by printToKeyboard(), recorded by the journal once typed */
+    struct TypedToken {
+        TidKey key;
+        uint16_t token; //< KeyboardScheduler::getNumQueued() when queued
+        CardIndex slot;
+    };
+    typedef CQueue<TypedToken, KEYBOARD_BUFFER_SIZE / 16, byte> TypedTokenQueue;
+
+    /**
+    * @brief Store one inventoried card
+    * @detail Update the timestamp of a known card, or store a new card (status
+    * false) to the slot of an expired card or to the end of the queue.
+    * @param
+    * - key: packed TID of the card.
+    * - now: time of the inventory session (`millis()`).
+    * @return slot of the card, `_index.NONE` if the database is full
+    */
+    CardIndex _store(const TidKey key, const uint32_t now);
+
+    /* Report an event of a card to the callback, if any */
+    void _emit(const CardEventType type, const CardIndex slot, const TidKey key,
+               const uint32_t now);
+
+    /* Draw the random bytes of the token of a new card */
+    void _drawKey(byte* key);
+
+    /* Record a change of a card to the journal, if any */
+    void _log(const JournalOp op, const TidKey key, const uint32_t now);
+
+    /* Record the cards whose tokens have been typed to the journal */
+    void _logTyped(const uint32_t now);
+
+    /* Return true if the token of a card is queued but not typed yet */
+    bool _isTyping(const CardIndex slot);
+
+    /* Start writing a snapshot of the typed cards (see _writeJournal()) */
+    void _beginCheckpoint();
+
+    /* Write at most `maxBytes` bytes of the journal */
+    size_t _writeJournal(const size_t maxBytes);
+
+    /* Apply a card or record replayed by restore() */
+    static void _restoreRecord(JournalOp op, TidKey key, void* context);
+
+    CardQueue _database; //< database stored cards
+    TidIndex<TID_INDEX_SIZE, CardIndex> _index; //< TID -> slot of `_database`
+    ExpiryList<DATABASE_CAPACITY, CardIndex> _expiry; //< slots by last-seen time
+    SessionFilter<SESSION_FILTER_SIZE, CardIndex> _seen; //< TIDs merged in the
+                                                         //  session
+    KeyboardScheduler _keyboard; //< keyboard output of printToKeyboard()
+    uint32_t _numArrivals; //< new cards stored so far
+    DatabaseJournal* _journal; //< persistent copy of the typed cards
+    bool _isCheckpointDue; //< a change was not batched, write a snapshot
+    CardIndex _snapshotSlot; //< next slot added to the snapshot
+    TypedTokenQueue _typing; //< tokens not typed yet, with a journal only
+    TokenEncoding _encoding; //< of the tokens typed by printToKeyboard()
+    bool _hasCheck; //< a check character ends the tokens
+    EventCallback _callback; //< called for every event of a card
+    void* _context; //< passed to `_callback`
+    CQueue<CardIndex, DATABASE_CAPACITY, CardIndex> _arrivals; //< slots of new
+                                                               //  cards to print
+    bool _isArrivalLost; //< `_arrivals` was full, visit the whole database
+    byte _keys[DATABASE_CAPACITY][HASH_KEY_SIZE]; //< random bytes of the tokens
+    uint32_t _keyState; //< xorshift keystream of `_keys`
+
+    static_assert(TID_INDEX_SIZE >= 2 * DATABASE_CAPACITY,
+                  "TID_INDEX_SIZE must be at least twice DATABASE_CAPACITY");
 };
 
 
@@ -140,6 +418,7 @@ void _setPrefix(const String prefix);
 
 /**
 * @brief Convert TID to string
+* @detail Allocates a `String`, see printTid() to format into a buffer.
 * @param reference to TID
 * @return String of converted TID
 */
@@ -147,14 +426,60 @@ String toString(TID& tid);
 
 /**
 * @brief Hash generation
+* @detail Allocates `String`s, see printHash() to format into a buffer.
 *
 * @param 
 *    - tid: TID of card needs to be hashed.
 *    - prefix: for Tictag JSC.
+*    - encoding: see `TokenEncoding` (default: 3 decimal digits per byte).
+*    - hasCheck: true to append a check character.
 *
 * @return constant string
 */
-const String generateHash(TID tid, const String prefix);
+const String generateHash(TID tid, const String prefix,
+                          const TokenEncoding encoding = TOKEN_DECIMAL,
+                          const bool hasCheck = false);
+
+/**
+* @brief Print a TID (3 decimal digits per byte, same as toString())
+* @detail Nothing is allocated, e.g. print into a `TextBuffer`.
+* @param
+* - out: output (e.g. `Serial`, `Keyboard`, `TextBuffer`).
+* - key: packed TID.
+* @return none
+*/
+void printTid(Print& out, const TidKey key);
+
+/**
+* @brief Print the hash of a TID (same as generateHash())
+* @detail Nothing is allocated, e.g. print into a `TextBuffer`.
+* @param
+* - out: output (e.g. `Serial`, `Keyboard`, `TextBuffer`).
+* - tid: TID of card needs to be hashed.
+* - prefix: null-terminated prefix, for Tictag JSC.
+* - encoding: see `TokenEncoding` (default: 3 decimal digits per byte).
+* - hasCheck: true to append a check character.
+* @return none
+*/
+void printHash(Print& out, TID tid, const char* prefix,
+               const TokenEncoding encoding = TOKEN_DECIMAL,
+               const bool hasCheck = false);
+
+/**
+* @brief Print the hash of a TID with given random bytes
+* @detail Same as printHash(), but the random bytes are not drawn (e.g. see
+* `Database::printToken()`).
+* @param
+* - out: output (e.g. `Serial`, `Keyboard`, `TextBuffer`).
+* - tid: TID of card needs to be hashed.
+* - key: `HASH_KEY_SIZE` random bytes, from 1 to 254.
+* - prefix: null-terminated prefix, for Tictag JSC.
+* - encoding: see `TokenEncoding`.
+* - hasCheck: true to append a check character.
+* @return none
+*/
+void printHash(Print& out, const TID& tid, const byte* key, const char* prefix,
+               const TokenEncoding encoding, const bool hasCheck);
 
 /*
 * These functions are used as arguments passed to `CQueue::_debugPrint()` for 
@@ -167,7 +492,11 @@ void prtCardInfo(Card* card);
 /* Print welcome message - for testing card.status */
 void prtCardMsg(Card* card);
 
-/* Print hased TID to keyboard */
+/*
+* Print hased TID to keyboard (blocking, see Database::printToKeyboard()).
+* The random bytes are drawn on every call, see Database::printToken() for the
+* token of a card of the database.
+*/
 void prtCardKeyBoard(Card* card);
 
 #endif
@@ -0,0 +1,446 @@
+#include "DatabaseJournal.h"
+
+#include "Crc16.h"
+
+/*
+* Sizes (bytes) of the layout, see `DatabaseJournal.h`. Integers are stored
+* low byte first.
+* - Key: TID size, then the 6 bytes of the TID.
+* - Header: generation (4 bytes), number of cards (2 bytes), CRC-16 of the
+*   cards, the generation and the number of cards (2 bytes).
+* - Record: operation, key, CRC-16 (seeded with the generation).
+*/
+enum JournalLayout: byte {
+    JOURNAL_KEY_SIZE        = MAX_SIZE_TID + 1,
+    JOURNAL_HEADER_SIZE     = 8,
+    JOURNAL_RECORD_SIZE     = JOURNAL_KEY_SIZE + 3
+};
+
+// Initial CRC-16, so that other data in the storage is unlikely to be valid
+#define JOURNAL_CRC_INIT             0x4A55
+
+/* Operation being written by write() */
+enum JournalState: byte {
+    JOURNAL_IDLE            = 0,
+    JOURNAL_FLUSH,          //< Records of the batch
+    JOURNAL_CARDS,          //< Cards of a snapshot, more may be added
+    JOURNAL_CARDS_END,      //< Last cards of a snapshot, then the header
+    JOURNAL_HEADER          //< Header of a snapshot
+};
+
+/* Store a packed TID */
+static void encodeKey(const TidKey key, byte* data)
+{
+    data[0] = getTidSize(key);
+    for (byte i = 0; i < MAX_SIZE_TID; i++)
+        data[i + 1] = (byte)(key >> (56 - 8 * i));
+}
+
+/* Load a packed TID, return false if it is not a TID */
+static bool decodeKey(const byte* data, TidKey& key)
+{
+    if (data[0] > MAX_SIZE_TID)
+        return false;
+    key = packTid(data + 1, data[0]);
+    return true;
+}
+
+/* Store an integer, low byte first */
+static void encodeInt(uint32_t value, byte* data, const byte size)
+{
+    for (byte i = 0; i < size; i++) {
+        data[i] = (byte)value;
+        value >>= 8;
+    }
+}
+
+/* Load an integer stored low byte first */
+static uint32_t decodeInt(const byte* data, const byte size)
+{
+    uint32_t value = 0;
+    for (byte i = size; i > 0; i--)
+        value = (value << 8) | data[i - 1];
+    return value;
+}
+
+/* Constructor */
+DatabaseJournal::DatabaseJournal(Storage& storage): _storage(storage)
+{
+    _maxRecords = 0;
+    _active = 0;
+    _count = 0;
+    _setGeneration(0);
+    _numPending = 0;
+    _pendingSince = 0;
+    _snapshotCount = 0;
+    _snapshotCrc = JOURNAL_CRC_INIT;
+    _state = JOURNAL_IDLE;
+    _numFlushing = 0;
+    _dataSize = 0;
+    _dataWritten = 0;
+    _address = 0;
+}
+
+/**
+* @public
+* @brief Find the last snapshot and the end of its journal
+*/
+Status DatabaseJournal::begin()
+{
+    size_t size = _storage.getSize();
+    if (size < getMinSize())
+        return STATUS_ERROR;
+
+    _maxRecords = (size - 2 * getSlotSize()) / JOURNAL_RECORD_SIZE;
+    _numPending = 0;
+    _state = JOURNAL_IDLE;
+    _dataSize = 0;
+    _dataWritten = 0;
+
+    uint32_t generation[2];
+    uint16_t count[2];
+    bool isValid[2];
+    for (byte slot = 0; slot < 2; slot++)
+        isValid[slot] = _readSnapshot(slot, generation[slot], count[slot]);
+
+    if (!isValid[0] && !isValid[1]) {
+        // Nothing to restore: empty snapshot of generation 1 in slot 0
+        _active = 1;
+        _setGeneration(0);
+        beginSnapshot();
+        commitSnapshot();
+        while (isBusy())
+            write(SIZE_MAX);
+        return STATUS_SUCCESS;
+    }
+
+    _active = (isValid[1] && (!isValid[0] || (generation[1] > generation[0])))
+              ? 1 : 0;
+    _count = count[_active];
+    _setGeneration(generation[_active]);
+
+    // The journal ends at the first record which is torn or older
+    JournalOp op;
+    TidKey key;
+    while ((_numRecords < _maxRecords) && _readRecord(_numRecords, op, key))
+        _numRecords++;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+* @public
+* @brief Replay the snapshot and the journal
+*/
+size_t DatabaseJournal::replay(RecordCallback callback, void* context)
+{
+    byte data[JOURNAL_KEY_SIZE];
+    TidKey key;
+    size_t address = _slotAddress(_active) + JOURNAL_HEADER_SIZE;
+
+    for (uint16_t i = 0; i < _count; i++) {
+        _storage.read(address, data, sizeof(data));
+        address += sizeof(data);
+        if (decodeKey(data, key)) //< Checked by begin()
+            callback(JOURNAL_PRINTED, key, context);
+    }
+
+    JournalOp op;
+    for (size_t i = 0; i < _numRecords; i++) {
+        if (_readRecord(i, op, key))
+            callback(op, key, context);
+    }
+
+    return _count + _numRecords;
+}
+
+/**
+* @public
+* @brief Record a change (in RAM)
+*/
+Status DatabaseJournal::append(const JournalOp op, const TidKey key,
+                               const uint32_t now)
+{
+    if (isFull())
+        return ERR_QUEUE_FULL;
+
+    if (_numPending == 0)
+        _pendingSince = now;
+    _ops[_numPending] = op;
+    _keys[_numPending] = key;
+    _numPending++;
+    return STATUS_SUCCESS;
+}
+
+/* Return true if the batch is full */
+bool DatabaseJournal::isFull()
+{
+    return _numPending == JOURNAL_BATCH;
+}
+
+/* Return true if the batch should be flushed (full, or old enough) */
+bool DatabaseJournal::isDue(const uint32_t now)
+{
+    return (_numPending > 0)
+           && (isFull() || (now - _pendingSince >= JOURNAL_FLUSH_PERIOD));
+}
+
+/**
+* @public
+* @brief Start writing the batch to the journal (see write())
+*/
+Status DatabaseJournal::beginFlush()
+{
+    if (isBusy())
+        return STATUS_ERROR;
+    if (_numPending == 0)
+        return STATUS_SUCCESS;
+    if (_numRecords + _numPending > _maxRecords)
+        return ERR_QUEUE_FULL;
+
+    _address = _recordAddress(_numRecords);
+    byte record[JOURNAL_RECORD_SIZE];
+    for (byte i = 0; i < _numPending; i++) {
+        record[0] = _ops[i];
+        encodeKey(_keys[i], record + 1);
+        uint16_t crc = crc16Update(_recordSeed, record, JOURNAL_KEY_SIZE + 1);
+        encodeInt(crc, record + JOURNAL_KEY_SIZE + 1, 2);
+        _buffer(record, sizeof(record));
+    }
+
+    _numFlushing = _numPending;
+    _numPending = 0;
+    _state = JOURNAL_FLUSH;
+    return STATUS_SUCCESS;
+}
+
+/**
+* @public
+* @brief Start writing a snapshot to the other slot
+*/
+Status DatabaseJournal::beginSnapshot()
+{
+    if (isBusy())
+        return STATUS_ERROR;
+
+    _snapshotCount = 0;
+    _snapshotCrc = JOURNAL_CRC_INIT;
+    _numPending = 0; //< The snapshot has these changes
+    _address = _slotAddress(1 - _active) + JOURNAL_HEADER_SIZE;
+    _state = JOURNAL_CARDS;
+    return STATUS_SUCCESS;
+}
+
+/* Return true if addSnapshot() can buffer a card */
+bool DatabaseJournal::canAddSnapshot()
+{
+    return (_state == JOURNAL_CARDS) && (_snapshotCount < DATABASE_CAPACITY)
+           && ((size_t)_dataSize + JOURNAL_KEY_SIZE <= sizeof(_data));
+}
+
+/**
+* @public
+* @brief Add a typed card to the snapshot
+*/
+Status DatabaseJournal::addSnapshot(const TidKey key)
+{
+    if (!canAddSnapshot())
+        return ERR_QUEUE_FULL;
+
+    byte data[JOURNAL_KEY_SIZE];
+    encodeKey(key, data);
+    _buffer(data, sizeof(data));
+    _snapshotCrc = crc16Update(_snapshotCrc, data, sizeof(data));
+    _snapshotCount++;
+    return STATUS_SUCCESS;
+}
+
+/**
+* @public
+* @brief End the cards of the snapshot
+*/
+Status DatabaseJournal::commitSnapshot()
+{
+    if (_state == JOURNAL_CARDS)
+        _state = JOURNAL_CARDS_END;
+    return STATUS_SUCCESS;
+}
+
+/**
+* @public
+* @brief Write the operation started by beginFlush() or beginSnapshot()
+*/
+size_t DatabaseJournal::write(const size_t maxBytes)
+{
+    size_t written = 0;
+
+    while (_state != JOURNAL_IDLE) {
+        if (_dataWritten < _dataSize) {
+            size_t size = _dataSize - _dataWritten;
+            if (size > maxBytes - written)
+                size = maxBytes - written;
+            if (size == 0)
+                break; //< Resume next time
+            _storage.write(_address, _data + _dataWritten, size);
+            _address += size;
+            _dataWritten += size;
+            written += size;
+            continue;
+        }
+
+        _dataSize = 0;
+        _dataWritten = 0;
+        if (_state == JOURNAL_CARDS)
+            break; //< Waiting for addSnapshot() or commitSnapshot()
+
+        // Every step is durable before the next one, e.g. the cards before
+        // the header which makes them valid
+        _storage.commit();
+
+        if (_state == JOURNAL_FLUSH) {
+            _numRecords += _numFlushing;
+            _numFlushing = 0;
+            _state = JOURNAL_IDLE;
+        } else if (_state == JOURNAL_CARDS_END) {
+            byte header[JOURNAL_HEADER_SIZE];
+            encodeInt(_generation + 1, header, 4);
+            encodeInt(_snapshotCount, header + 4, 2);
+            encodeInt(crc16Update(_snapshotCrc, header, 6), header + 6, 2);
+
+            _address = _slotAddress(1 - _active);
+            _buffer(header, sizeof(header));
+            _state = JOURNAL_HEADER;
+        } else { //< JOURNAL_HEADER: the snapshot is valid
+            _active = 1 - _active;
+            _count = _snapshotCount;
+            _setGeneration(_generation + 1);
+            _state = JOURNAL_IDLE;
+        }
+    }
+
+    return written;
+}
+
+/* Return true if an operation is being written (see write()) */
+bool DatabaseJournal::isBusy()
+{
+    return _state != JOURNAL_IDLE;
+}
+
+/* Return true if a snapshot is started but not committed yet */
+bool DatabaseJournal::isSnapshotOpen()
+{
+    return _state == JOURNAL_CARDS;
+}
+
+/* Get number of records in the journal (not counting the batch) */
+size_t DatabaseJournal::getNumRecords()
+{
+    return _numRecords;
+}
+
+/* Get generation of the current snapshot (number of checkpoints) */
+uint32_t DatabaseJournal::getGeneration()
+{
+    return _generation;
+}
+
+/* Get number of bytes of a snapshot slot */
+size_t DatabaseJournal::getSlotSize()
+{
+    return JOURNAL_HEADER_SIZE + (size_t)DATABASE_CAPACITY * JOURNAL_KEY_SIZE;
+}
+
+/* Get minimum number of bytes of the storage */
+size_t DatabaseJournal::getMinSize()
+{
+    return 2 * getSlotSize() + JOURNAL_BATCH * JOURNAL_RECORD_SIZE;
+}
+
+/* Address of the first byte of a snapshot slot */
+size_t DatabaseJournal::_slotAddress(const byte slot)
+{
+    return slot * getSlotSize();
+}
+
+/* Address of the first byte of a record of the journal */
+size_t DatabaseJournal::_recordAddress(const size_t record)
+{
+    return 2 * getSlotSize() + record * JOURNAL_RECORD_SIZE;
+}
+
+/**
+* @private
+* @brief Read and check the header and the cards of a snapshot slot
+*/
+bool DatabaseJournal::_readSnapshot(const byte slot, uint32_t& generation,
+                                    uint16_t& count)
+{
+    byte header[JOURNAL_HEADER_SIZE];
+    size_t address = _slotAddress(slot);
+    _storage.read(address, header, sizeof(header));
+
+    generation = decodeInt(header, 4);
+    count = (uint16_t)decodeInt(header + 4, 2);
+    if (count > DATABASE_CAPACITY)
+        return false;
+
+    byte data[JOURNAL_KEY_SIZE];
+    TidKey key;
+    uint16_t crc = JOURNAL_CRC_INIT;
+    address += JOURNAL_HEADER_SIZE;
+    for (uint16_t i = 0; i < count; i++) {
+        _storage.read(address, data, sizeof(data));
+        address += sizeof(data);
+        if (!decodeKey(data, key))
+            return false;
+        crc = crc16Update(crc, data, sizeof(data));
+    }
+
+    crc = crc16Update(crc, header, 6);
+    return crc == decodeInt(header + 6, 2);
+}
+
+/**
+* @private
+* @brief Read and check a record of the journal
+*/
+bool DatabaseJournal::_readRecord(const size_t record, JournalOp& op,
+                                  TidKey& key)
+{
+    byte data[JOURNAL_RECORD_SIZE];
+    _storage.read(_recordAddress(record), data, sizeof(data));
+
+    uint16_t crc = crc16Update(_recordSeed, data, JOURNAL_KEY_SIZE + 1);
+    if (crc != decodeInt(data + JOURNAL_KEY_SIZE + 1, 2))
+        return false;
+    if ((data[0] != JOURNAL_PRINTED) && (data[0] != JOURNAL_EXPIRED))
+        return false;
+
+    op = (JournalOp)data[0];
+    return decodeKey(data + 1, key);
+}
+
+/**
+* @private
+* @brief Set the generation, the journal is empty
+*/
+void DatabaseJournal::_setGeneration(const uint32_t generation)
+{
+    byte data[4];
+    encodeInt(generation, data, sizeof(data));
+
+    _generation = generation;
+    _recordSeed = crc16Update(JOURNAL_CRC_INIT, data, sizeof(data));
+    _numRecords = 0;
+}
+
+/**
+* @private
+* @brief Queue bytes to the buffer of write()
+*/
+void DatabaseJournal::_buffer(const byte* data, const size_t size)
+{
+    memcpy(_data + _dataSize, data, size);
+    _dataSize += size;
+}
@@ -0,0 +1,238 @@
+#ifndef _DATABASE_JOURNAL_H_
+#define _DATABASE_JOURNAL_H_
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "attribute.h"
+#include "Storage.h"
+#include "TidKey.h"
+
+/* Change of a card recorded by the journal */
+enum JournalOp: byte {
+    JOURNAL_PRINTED    = 0x01, //< The card has been typed to the keyboard
+    JOURNAL_EXPIRED    = 0x02  //< A typed card has been disconnected
+};
+
+/*
+* @brief Persistent copy of the typed cards of a `Database`
+* @detail The cards which have been typed to the keyboard (`.status = true`)
+* and are still connected are kept in a `Storage`, so that after a reset
+* they are not typed again (see `Database::restore()`).
+*
+* Layout of the storage:
+* +------------------+------------------+-----------------------------------+
+* | Snapshot slot 0  | Snapshot slot 1  | Journal                           |
+* +------------------+------------------+-----------------------------------+
+* - Snapshot: header (generation, number of cards, CRC-16) and the TIDs of
+*   the typed cards, `getSlotSize()` bytes.
+* - Journal: records (operation, TID, CRC-16) appended since the snapshot.
+*
+* - Changes are batched in RAM (up to `JOURNAL_BATCH` records, for at most
+*   `JOURNAL_FLUSH_PERIOD` ms), then appended to the journal.
+* - When the journal is full, a new snapshot is written to the other slot
+*   (checkpoint), with the next generation. The old snapshot and its journal
+*   stay valid until the header of the new one is written.
+* - The CRC-16 of a record is seeded with the generation, so the records of
+*   older generations (and torn records) end the journal.
+* - Nothing is written by append(): beginFlush() and beginSnapshot() start an
+*   operation, then write() writes a few bytes of it at a time, so that a
+*   long write (e.g. a snapshot to EEPROM) does not block `loop()`.
+*
+* A reset therefore loses at most the records which are not written yet,
+* whose cards are typed again, and the storage is never left inconsistent.
+* Each byte of the storage is written at most once per checkpoint.
+*
+* @example
+* ```
+*     DatabaseJournal journal(storage); //< e.g. `EepromStorage`
+*
+*     database->restore(journal); //< setup()
+*     database->sync(millis()); //< loop()
+* ```
+*/
+class DatabaseJournal
+{
+public:
+    /**
+    * Called for each change replayed from the storage.
+    * - op: operation.
+    * - key: packed TID of the card.
+    * - context: pointer given to replay().
+    */
+    typedef void (*RecordCallback)(JournalOp op, TidKey key, void* context);
+
+    /**
+    * @brief Constructor
+    * @param
+    * - storage: non-volatile storage, at least getMinSize() bytes.
+    */
+    DatabaseJournal(Storage& storage);
+
+    /**
+    * @brief Find the last snapshot and the end of its journal
+    * @detail An empty snapshot is written if the storage holds no valid one
+    * (e.g. erased storage, or `DATABASE_CAPACITY` has changed).
+    * @param none
+    * @return
+    * - STATUS_SUCCESS: the journal is ready.
+    * - STATUS_ERROR: the storage is smaller than getMinSize().
+    */
+    Status begin();
+
+    /**
+    * @brief Replay the snapshot and the journal
+    * @detail The cards of the snapshot are reported as `JOURNAL_PRINTED`,
+    * then the records of the journal in the order they were appended.
+    * @param
+    * - callback: called for each card or record.
+    * - context: pointer passed to `callback`.
+    * @return number of cards and records replayed
+    */
+    size_t replay(RecordCallback callback, void* context);
+
+    /**
+    * @brief Record a change (in RAM)
+    * @param
+    * - op: operation.
+    * - key: packed TID of the card.
+    * - now: current time (`millis()`).
+    * @return
+    * - STATUS_SUCCESS: the change is batched.
+    * - ERR_QUEUE_FULL: the batch is full, the change is lost (write a
+    *   snapshot to record it).
+    */
+    Status append(const JournalOp op, const TidKey key, const uint32_t now);
+
+    /* Return true if the batch is full */
+    bool isFull();
+
+    /* Return true if the batch should be flushed (full, or old enough) */
+    bool isDue(const uint32_t now);
+
+    /**
+    * @brief Start writing the batch to the journal (see write())
+    * @detail The batch is emptied, the next changes are batched meanwhile.
+    * @param none
+    * @return
+    * - STATUS_SUCCESS: the batch is being written (or empty).
+    * - ERR_QUEUE_FULL: the journal is full, write a snapshot instead.
+    * - STATUS_ERROR: an operation is being written (see isBusy()), nothing
+    *   is started.
+    */
+    Status beginFlush();
+
+    /**
+    * @brief Start writing a snapshot to the other slot
+    * @detail The batch is emptied: the snapshot has these changes. Then add
+    * the typed cards (addSnapshot()) and commitSnapshot(), while write() is
+    * writing them. The changes recorded meanwhile are flushed to the journal
+    * of the snapshot, so replaying both gives the cards as they are when the
+    * snapshot is committed.
+    * @param none
+    * @return
+    * - STATUS_SUCCESS: the snapshot is started.
+    * - STATUS_ERROR: an operation is being written (see isBusy()), nothing
+    *   is started.
+    */
+    Status beginSnapshot();
+
+    /* Return true if addSnapshot() can buffer a card */
+    bool canAddSnapshot();
+
+    /**
+    * @brief Add a typed card to the snapshot
+    * @param
+    * - key: packed TID of the card.
+    * @return
+    * - STATUS_SUCCESS: the card is buffered, write() writes it.
+    * - ERR_QUEUE_FULL: the snapshot already has `DATABASE_CAPACITY` cards,
+    *   or the buffer is full (see canAddSnapshot()).
+    */
+    Status addSnapshot(const TidKey key);
+
+    /**
+    * @brief End the cards of the snapshot
+    * @detail write() then writes the header: the snapshot replaces the
+    * previous one and the journal is emptied.
+    * @param none
+    * @return STATUS_SUCCESS
+    */
+    Status commitSnapshot();
+
+    /**
+    * @brief Write the operation started by beginFlush() or beginSnapshot()
+    * @detail Resumes where the last call stopped. A snapshot waits for
+    * addSnapshot() or commitSnapshot() once its buffered cards are written.
+    * @param
+    * - maxBytes: maximum number of bytes to write.
+    * @return number of bytes written
+    */
+    size_t write(const size_t maxBytes);
+
+    /* Return true if an operation is being written (see write()) */
+    bool isBusy();
+
+    /* Return true if a snapshot is started but not committed yet */
+    bool isSnapshotOpen();
+
+    /* Get number of records in the journal (not counting the batch) */
+    size_t getNumRecords();
+
+    /* Get generation of the current snapshot (number of checkpoints) */
+    uint32_t getGeneration();
+
+    /* Get number of bytes of a snapshot slot */
+    static size_t getSlotSize();
+
+    /* Get minimum number of bytes of the storage */
+    static size_t getMinSize();
+
+private:
+    /* Address of the first byte of a snapshot slot */
+    size_t _slotAddress(const byte slot);
+
+    /* Address of the first byte of a record of the journal */
+    size_t _recordAddress(const size_t record);
+
+    /* Read and check the header and the cards of a snapshot slot */
+    bool _readSnapshot(const byte slot, uint32_t& generation, uint16_t& count);
+
+    /* Read and check a record of the journal */
+    bool _readRecord(const size_t record, JournalOp& op, TidKey& key);
+
+    /* Set the generation, the journal is empty */
+    void _setGeneration(const uint32_t generation);
+
+    /* Queue bytes to the buffer of write() */
+    void _buffer(const byte* data, const size_t size);
+
+    Storage& _storage;
+    size_t _maxRecords; //< Number of records the journal can hold
+
+    byte _active; //< Slot of the current snapshot
+    uint32_t _generation;
+    uint16_t _count; //< Number of cards of the current snapshot
+    uint16_t _recordSeed; //< Initial CRC-16 of the records of the generation
+    size_t _numRecords; //< Records in the journal
+
+    JournalOp _ops[JOURNAL_BATCH]; //< Batch of records, not written yet
+    TidKey _keys[JOURNAL_BATCH];
+    byte _numPending;
+    uint32_t _pendingSince; //< millis() of the oldest record of the batch
+
+    uint16_t _snapshotCount; //< Cards of the snapshot being written
+    uint16_t _snapshotCrc;
+
+    byte _state; //< Operation being written, see `DatabaseJournal.cpp`
+    byte _numFlushing; //< Records of the batch being written
+    byte _data[JOURNAL_BATCH * (MAX_SIZE_TID + 4)]; //< Bytes to write (a batch
+                                                     //  of records at most)
+    byte _dataSize;
+    byte _dataWritten; //< Bytes of `_data` written so far
+    size_t _address; //< Address of the first byte of `_data` not written
+};
+
+#endif
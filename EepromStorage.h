@@ -0,0 +1,71 @@
+#ifndef _EEPROM_STORAGE_H_
+#define _EEPROM_STORAGE_H_
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Storage.h"
+
+/*
+* @brief Storage in the EEPROM of the MCU
+* @detail A range of the EEPROM (e.g. 1 KB on the ATmega32U4) is used by a
+* `DatabaseJournal`. Only the bytes which change are written (EEPROM cells
+* endure about 100 000 writes), and writing one byte takes about 3.3 ms on AVR.
+*
+* On cores which emulate the EEPROM in flash (ESP8266, ESP32, RP2040), bytes
+* are written to a RAM copy and commit() programs the flash sector.
+*
+* @example
+* ```
+*     EepromStorage storage(0, EEPROM.length()); //< The whole EEPROM
+*     DatabaseJournal journal(storage);
+* ```
+*/
+class EepromStorage: public Storage
+{
+public:
+    /**
+    * @brief Constructor
+    * @param
+    * - base: address of the first byte of the range in the EEPROM.
+    * - size: number of bytes of the range.
+    */
+    EepromStorage(const size_t base, const size_t size):
+        _base(base), _size(size) {}
+
+    size_t getSize() override
+    {
+        return _size;
+    }
+
+    void read(const size_t address, byte* data, const size_t size) override
+    {
+        for (size_t i = 0; i < size; i++)
+            data[i] = EEPROM.read(_base + address + i);
+    }
+
+    void write(const size_t address, const byte* data,
+               const size_t size) override
+    {
+        for (size_t i = 0; i < size; i++) {
+            if (EEPROM.read(_base + address + i) != data[i])
+                EEPROM.write(_base + address + i, data[i]);
+        }
+    }
+
+    void commit() override
+    {
+#if defined(ESP8266) || defined(ESP32) || defined(ARDUINO_ARCH_RP2040)
+        EEPROM.commit();
+#endif
+    }
+
+private:
+    size_t _base;
+    size_t _size;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef _EXPIRY_LIST_H_
+#define _EXPIRY_LIST_H_
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "attribute.h"
+
+/*
+* @brief Expiry tracking of the database slots
+* @detail Slots of live cards are kept in a doubly linked list ordered by the
+* time their cards were last seen: a card seen now is moved to the tail, so the
+* head is always the card which was seen the longest time ago. Finding an
+* expired card is O(1) (compare the head with `EXPIRE_TIME`) and a sweep only
+* visits the cards which are actually expired.
+*
+* Released (expired) slots are kept in a free list, ready to be reused.
+*
+* - Capacity: number of slots (capacity of the database).
+* - Slot: data type of slot numbers (see `CardIndex`).
+*
+* @note
+* Cards must be touched with non-decreasing timestamps (e.g. `millis()`
+* sampled once per poll), otherwise the list is not ordered anymore.
+*/
+template <size_t Capacity, typename Slot = byte>
+class ExpiryList
+{
+public:
+    static const Slot NONE = (Slot)~(Slot)0; //< No slot
+
+    ExpiryList()
+    {
+        for (size_t i = 0; i < Capacity; i++) {
+            _prev[i] = NONE;
+            _next[i] = NONE;
+        }
+        _head = NONE;
+        _tail = NONE;
+        _free = NONE;
+    }
+
+    /**
+    * @brief A card has just been seen
+    * @detail Move its slot to the tail of the list (or add it).
+    * @param
+    * - slot: slot of the card, must not be in the free list.
+    * @return none
+    */
+    void touch(const Slot slot)
+    {
+        if (slot == _tail)
+            return;
+
+        if (isLive(slot))
+            _unlink(slot);
+
+        _prev[slot] = _tail;
+        _next[slot] = NONE;
+        if (_tail != NONE)
+            _next[_tail] = slot;
+        else
+            _head = slot;
+        _tail = slot;
+    }
+
+    /**
+    * @brief Release the slot of an expired card
+    * @detail Remove the slot from the list and add it to the free list.
+    * @param
+    * - slot: slot of the card, must be live.
+    * @return none
+    */
+    void release(const Slot slot)
+    {
+        _unlink(slot);
+        _next[slot] = _free;
+        _free = slot;
+    }
+
+    /**
+    * @brief Get a released slot
+    * @return slot removed from the free list, NONE if there is no free slot.
+    */
+    Slot acquire()
+    {
+        Slot slot = _free;
+        if (slot != NONE) {
+            _free = _next[slot];
+            _next[slot] = NONE;
+        }
+        return slot;
+    }
+
+    /* Get the slot of the card which was seen the longest time ago */
+    Slot getOldest()
+    {
+        return _head;
+    }
+
+    /* Return true if the slot belongs to a live card */
+    bool isLive(const Slot slot)
+    {
+        return (_prev[slot] != NONE) || (_head == slot);
+    }
+
+private:
+    void _unlink(const Slot slot)
+    {
+        if (_prev[slot] != NONE)
+            _next[_prev[slot]] = _next[slot];
+        else
+            _head = _next[slot];
+
+        if (_next[slot] != NONE)
+            _prev[_next[slot]] = _prev[slot];
+        else
+            _tail = _prev[slot];
+
+        _prev[slot] = NONE;
+        _next[slot] = NONE;
+    }
+
+    Slot _prev[Capacity];
+    Slot _next[Capacity]; //< Also links the free list
+    Slot _head; //< Oldest live card
+    Slot _tail; //< Newest live card
+    Slot _free; //< Released slots
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "Instrument.h"
+
+#if defined(UHF_INSTRUMENT)
+
+Instrument instrument;
+
+/* Codes of `Status`, the index of a code is its counter */
+static const byte STATUS_CODES[INSTRUMENT_STATUSES - 1] = {
+    STATUS_ERROR, STATUS_SUCCESS, ERR_INV_TIMEOUT, ERR_INV_FRAME_OUT,
+    ERR_INV_MEM_OUT, ERR_INV_NO_CARD, ERR_TID_SIZE, ERR_NUM_CARDS, ERR_CRC,
+    ERR_QUEUE_FULL, ERR_QUEUE_EMPTY, ERR_READ_RS485, ERR_RS485_TIMEOUT,
+    STATUS_RS485_BUSY
+};
+
+static const char* const STAGE_NAMES[NUM_STAGES] = {
+    "serial", "crc", "update", "keyboard"
+};
+
+/* Add 1 to a counter, stop at its maximum */
+static inline void increase(uint16_t& counter)
+{
+    if (counter != 0xFFFF)
+        counter++;
+}
+
+Instrument::Instrument()
+{
+    reset();
+}
+
+/**
+* @public
+* @brief Record a span of a stage
+*/
+void Instrument::record(const byte stage, const uint32_t span, const byte status)
+{
+    // Bucket `i`: [2^(i-1), 2^i) us
+    byte bucket = 0;
+    for (uint32_t value = span; (value != 0) && (bucket < INSTRUMENT_BUCKETS - 1);
+         value >>= 1)
+        bucket++;
+    increase(_buckets[stage][bucket]);
+
+    byte code = 0;
+    while ((code < INSTRUMENT_STATUSES - 1) && (STATUS_CODES[code] != status))
+        code++;
+    increase(_statuses[stage][code]); //< Last counter: unknown codes
+
+    if (span > _max[stage])
+        _max[stage] = span;
+}
+
+/**
+* @public
+* @brief Print every stage in a compact form
+*/
+void Instrument::dump(Print& out)
+{
+    for (byte stage = 0; stage < NUM_STAGES; stage++) {
+        uint32_t count = 0;
+        byte numBuckets = 0;
+        for (byte i = 0; i < INSTRUMENT_BUCKETS; i++) {
+            count += _buckets[stage][i];
+            if (_buckets[stage][i] != 0)
+                numBuckets = i + 1;
+        }
+
+        out.print('@');
+        out.print(STAGE_NAMES[stage]);
+        out.print(" n=");
+        out.print((unsigned long)count);
+        out.print(" max=");
+        out.print((unsigned long)_max[stage]);
+
+        out.print(" h=");
+        for (byte i = 0; i < numBuckets; i++) {
+            if (i > 0)
+                out.print(',');
+            out.print((unsigned int)_buckets[stage][i]);
+        }
+
+        out.print(" s=");
+        bool isFirst = true;
+        for (byte i = 0; i < INSTRUMENT_STATUSES; i++) {
+            if (_statuses[stage][i] == 0)
+                continue;
+            if (!isFirst)
+                out.print(',');
+            isFirst = false;
+
+            if (i < INSTRUMENT_STATUSES - 1)
+                out.print(STATUS_CODES[i], HEX);
+            else
+                out.print('?');
+            out.print(':');
+            out.print((unsigned int)_statuses[stage][i]);
+        }
+        out.println();
+    }
+}
+
+/**
+* @public
+* @brief Clear every histogram and counter
+*/
+void Instrument::reset()
+{
+    memset(_buckets, 0, sizeof(_buckets));
+    memset(_statuses, 0, sizeof(_statuses));
+    memset(_max, 0, sizeof(_max));
+}
+
+/* Dump or reset the instrumentation on request */
+void instrumentPoll(Stream& serial)
+{
+    if (serial.available() <= 0)
+        return;
+
+    int command = serial.read();
+    if (command == '?')
+        instrument.dump(serial);
+    else if (command == '!')
+        instrument.reset();
+}
+
+#endif
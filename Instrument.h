@@ -0,0 +1,150 @@
+#ifndef _INSTRUMENT_H_
+#define _INSTRUMENT_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+
+/*
+* @brief Hot-path instrumentation (opt-in)
+* @detail Time spent in each stage of a poll is recorded into log-bucket
+* histograms of `micros()` spans, with a counter per `Status` code:
+*
+* +----------+--------------------------------+-----------------------------+
+* | Stage    | Span                           | Status                      |
+* +----------+--------------------------------+-----------------------------+
+* | serial   | request sent -> frame received | return value of receive()   |
+* |          | (getRawData() and sessions)    | (success or time-out)       |
+* | crc      | isDataPreserved()              | STATUS_SUCCESS or ERR_CRC   |
+* | update   | Database::updateDB() (merge of | STATUS_SUCCESS              |
+* |          | the cards into the database)   |                             |
+* | keyboard | Database::printToKeyboard()    | STATUS_SUCCESS or           |
+* |          |                                | ERR_QUEUE_FULL              |
+* +----------+--------------------------------+-----------------------------+
+*
+* - Bucket 0 counts spans of 0 us, bucket `i` spans of [2^(i-1), 2^i) us, the
+*   last bucket every longer span (>= 262 ms).
+* - Counters saturate at 65535, call instrumentReset() to start a new window.
+*
+* @note
+* Define `UHF_INSTRUMENT` (see `attribute.h`, or `-DUHF_INSTRUMENT=ON` for the
+* host build) to enable it. Otherwise every macro below expands to nothing and
+* instrumentDump()/instrumentPoll() are empty: no RAM, no cycles.
+*
+* @example
+* ```
+*     void loop()
+*     {
+*         instrumentPoll(Serial); //< '?' dumps the histograms, '!' resets
+*         ...
+*     }
+* ```
+* Dump (one line per stage, trailing empty buckets omitted, status in hex):
+* ```
+*     @serial n=42 max=51234 h=0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,40,2 s=1:40,1B:2
+* ```
+*/
+enum InstrumentStage: byte {
+    STAGE_SERIAL,
+    STAGE_CRC,
+    STAGE_UPDATE,
+    STAGE_KEYBOARD,
+
+    NUM_STAGES
+};
+
+#define INSTRUMENT_BUCKETS           20
+#define INSTRUMENT_STATUSES          15 //< Codes of `Status`, plus "other"
+
+#if defined(UHF_INSTRUMENT)
+
+class Instrument
+{
+public:
+    Instrument();
+
+    /**
+    * @brief Record a span of a stage
+    * @param
+    * - stage: see `InstrumentStage`.
+    * - span: time (us) spent in the stage.
+    * - status: result of the stage.
+    * @return none
+    */
+    void record(const byte stage, const uint32_t span, const byte status);
+
+    /* Print every stage in a compact form (see `Instrument.h`) */
+    void dump(Print& out);
+
+    /* Clear every histogram and counter */
+    void reset();
+
+private:
+    uint16_t _buckets[NUM_STAGES][INSTRUMENT_BUCKETS]; //< Spans per log bucket
+    uint16_t _statuses[NUM_STAGES][INSTRUMENT_STATUSES]; //< Results per code
+    uint32_t _max[NUM_STAGES]; //< Longest span (us)
+};
+
+extern Instrument instrument;
+
+/*
+* @brief Span of a stage, recorded when it goes out of scope (so every
+* `return` of the instrumented function is covered).
+*/
+class InstrumentSpan
+{
+public:
+    explicit InstrumentSpan(const byte stage):
+        _stage(stage), _status(STATUS_SUCCESS), _start(micros()) {}
+
+    ~InstrumentSpan() { instrument.record(_stage, micros() - _start, _status); }
+
+    void setStatus(const byte status) { _status = status; }
+
+private:
+    byte _stage;
+    byte _status;
+    uint32_t _start;
+};
+
+/* Time the rest of the enclosing block as `stage` (one per block) */
+#define UHF_SPAN(stage)              InstrumentSpan _uhfSpan(stage)
+
+/* Set the status recorded by UHF_SPAN() (no side effects in `status`!) */
+#define UHF_SPAN_STATUS(status)      _uhfSpan.setStatus(status)
+
+/* Record a span which started at `start` (micros()) */
+#define UHF_SPAN_RECORD(stage, start, status) \
+    instrument.record((stage), micros() - (start), (status))
+
+/**
+* @brief Dump or reset the instrumentation on request
+* @detail Reads one byte if available: '?' dumps to `serial`, '!' resets.
+* Other bytes are dropped.
+* @param
+* - serial: e.g. `Serial`.
+* @return none
+*/
+void instrumentPoll(Stream& serial);
+
+/* Print every stage to `out` */
+inline void instrumentDump(Print& out) { instrument.dump(out); }
+
+/* Clear every histogram and counter */
+inline void instrumentReset() { instrument.reset(); }
+
+#else
+
+#define UHF_SPAN(stage)
+#define UHF_SPAN_STATUS(status)
+#define UHF_SPAN_RECORD(stage, start, status)
+
+inline void instrumentPoll(Stream& serial) { (void)serial; }
+inline void instrumentDump(Print& out) { (void)out; }
+inline void instrumentReset() {}
+
+#endif
+
+#endif
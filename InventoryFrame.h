@@ -0,0 +1,135 @@
+#ifndef _INVENTORY_FRAME_H_
+#define _INVENTORY_FRAME_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "TidKey.h"
+
+/*
+* @brief Read-only view of the TIDs of an inventory response frame
+* @detail TIDs are read in place from the response buffer, nothing is copied:
+* `Database::updateDB()` packs each TID straight into its key (see
+* `TidKey.h`) and merges it into the database.
+*
+* The constructor checks the frame once:
+* - the status of the frame comes with tags (`STATUS_SUCCESS`,
+*   `ERR_INV_TIMEOUT`, `ERR_INV_FRAME_OUT` or `ERR_INV_MEM_OUT`),
+* - there are at most `MAX_CARDS` TIDs of at most `MAX_SIZE_TID` bytes,
+* - every TID ends before the CRC, according to the Len byte.
+* If getStatus() is not `STATUS_SUCCESS`, the view is empty.
+*
+* @example
+* ```
+*     InventoryFrame frame(rawData);
+*     for (InventoryFrame::Iterator it = frame.begin(); it != frame.end(); ++it)
+*         Serial.println(it.getSize());
+* ```
+*
+* @note
+* The view must not outlive the response buffer.
+*/
+class InventoryFrame
+{
+public:
+    /* Iterator over the TIDs of the frame */
+    class Iterator
+    {
+    public:
+        Iterator(const byte* sizeByte, byte pos): _sizeByte(sizeByte), _pos(pos) {}
+
+        /* Size (bytes) of the TID */
+        byte getSize() const { return *_sizeByte; }
+
+        /* Bytes of the TID, in the response buffer */
+        const byte* getData() const { return _sizeByte + 1; }
+
+        /* Packed TID (see `TidKey.h`) */
+        TidKey getKey() const { return packTid(getData(), getSize()); }
+
+        Iterator& operator++()
+        {
+            _sizeByte += *_sizeByte + 1; //< Next TID size byte
+            _pos++;
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const { return _pos == other._pos; }
+        bool operator!=(const Iterator& other) const { return _pos != other._pos; }
+
+    private:
+        const byte* _sizeByte; //< Size byte of the TID, followed by its bytes
+        byte _pos; //< Position of the TID in the frame
+    };
+
+    /**
+    * @brief Constructor
+    * @param
+    * - rawData: inventory response frame (e.g. `UHFRecv::getFrame()`).
+    */
+    InventoryFrame(const byte* rawData): _rawData(rawData), _numCards(0)
+    {
+        _status = _check();
+        if (_status == STATUS_SUCCESS)
+            _numCards = rawData[RE_INV_NUM_CARDS_INDEX];
+    }
+
+    /**
+    * @brief Get the result of the frame check
+    * @return
+    * - STATUS_SUCCESS: the TIDs of the frame can be read.
+    * - ERR_NUM_CARDS: number of TIDs is larger than `MAX_CARDS`.
+    * - ERR_TID_SIZE: a TID is larger than `MAX_SIZE_TID`, or runs past the
+    *   CRC of the frame.
+    * - For other values (status of the frame without tags), see
+    *   `doc/Protocols`.
+    */
+    Status getStatus() const { return _status; }
+
+    /* Get number of TIDs (0 if getStatus() is not `STATUS_SUCCESS`) */
+    byte getNumCards() const { return _numCards; }
+
+    /* Return true if more frames of the session follow (`ERR_INV_FRAME_OUT`) */
+    bool isContinued() const { return _rawData[RE_STATUS_INDEX] == ERR_INV_FRAME_OUT; }
+
+    Iterator begin() const { return Iterator(_rawData + RE_INV_TID_SIZE_INDEX, 0); }
+    Iterator end() const { return Iterator(NULL, _numCards); }
+
+private:
+    Status _check() const
+    {
+        byte status = _rawData[RE_STATUS_INDEX];
+
+        // These status codes come with the already inquired tags (see
+        // `doc/Protocols`), any other status code has no data.
+        if ((status != STATUS_SUCCESS) && (status != ERR_INV_TIMEOUT)
+            && (status != ERR_INV_FRAME_OUT) && (status != ERR_INV_MEM_OUT))
+            return (Status)status;
+
+        byte numCards = _rawData[RE_INV_NUM_CARDS_INDEX];
+        if (numCards > MAX_CARDS)
+            return ERR_NUM_CARDS;
+
+        // TIDs lie between the Num byte and the CRC (index Len - 1)
+        int crcIndex = (int)_rawData[RE_LENGTH_INDEX] - 1;
+        int sizeIndex = RE_INV_TID_SIZE_INDEX;
+        for (byte i = 0; i < numCards; i++) {
+            if (sizeIndex >= crcIndex)
+                return ERR_TID_SIZE;
+
+            byte size = _rawData[sizeIndex];
+            if ((size > MAX_SIZE_TID) || (sizeIndex + 1 + size > crcIndex))
+                return ERR_TID_SIZE;
+            sizeIndex += size + 1;
+        }
+        return STATUS_SUCCESS;
+    }
+
+    const byte* _rawData;
+    Status _status;
+    byte _numCards;
+};
+
+#endif
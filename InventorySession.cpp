@@ -0,0 +1,114 @@
+#include "InventorySession.h"
+
+/* Constructor */
+InventorySession::InventorySession(UHFRecv& uhf, Database& database):
+                                   _uhf(uhf), _database(database)
+{
+    _numFrames = 0;
+    _frameStatus = STATUS_SUCCESS;
+    _isActive = false;
+}
+
+/**
+* @public
+* @brief Start a new inventory session (non-blocking)
+*/
+Status InventorySession::start(const byte* request, size_t size)
+{
+    if (_isActive)
+        return STATUS_RS485_BUSY;
+    return _begin(_uhf.sendRequest(request, size));
+}
+
+/**
+* @public
+* @brief Start a new inventory session with a command stored in flash
+*/
+Status InventorySession::start_P(const byte* request, size_t size)
+{
+    if (_isActive)
+        return STATUS_RS485_BUSY;
+    return _begin(_uhf.sendRequest_P(request, size));
+}
+
+/**
+* @public
+* @brief Advance the session (non-blocking)
+*/
+Status InventorySession::poll()
+{
+    if (!_isActive)
+        return ERR_READ_RS485;
+
+    Status status = _uhf.receive();
+    if (status == STATUS_RS485_BUSY)
+        return status;
+
+    if (status != STATUS_SUCCESS) //< e.g. time-out of a continuation frame
+        return _finish(status);
+
+    byte* frame = _uhf.getFrame();
+    if (!_uhf.isDataPreserved()) //< CRC-16 is updated as bytes arrive
+        return _finish(ERR_CRC);
+
+    _numFrames++;
+    _frameStatus = frame[RE_STATUS_INDEX];
+
+    // Cards are merged straight from the response frame, those of the 
+    // previous frames are already in the database.
+    status = _database.updateDB(InventoryFrame(frame));
+    if (status != STATUS_SUCCESS)
+        return _finish(status);
+    
+    // More frames are coming
+    if (frame[RE_STATUS_INDEX] == ERR_INV_FRAME_OUT) {
+        _uhf.listen();
+        return STATUS_RS485_BUSY;
+    }
+    
+    return _finish(STATUS_SUCCESS);
+}
+
+/* Return true if a session is in progress */
+bool InventorySession::isBusy()
+{
+    return _isActive;
+}
+
+/* Get number of frames received in the current (or last) session */
+const byte InventorySession::getNumFrames()
+{
+    return _numFrames;
+}
+
+/* Get the status byte of the last frame */
+Status InventorySession::getFrameStatus()
+{
+    return (Status)_frameStatus;
+}
+
+/**
+* @private
+* @brief Start the session once its request is sent
+*/
+Status InventorySession::_begin(Status status)
+{
+    if (status != STATUS_SUCCESS)
+        return status; //< e.g. the bus is used by someone else
+
+    _numFrames = 0;
+    _isActive = true;
+    _database.beginSession();
+
+    return STATUS_SUCCESS;
+}
+
+/**
+* @private
+* @brief Finish the session
+*/
+Status InventorySession::_finish(Status status)
+{
+    _isActive = false;
+    return status;
+}
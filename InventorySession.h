@@ -0,0 +1,108 @@
+#ifndef _INVENTORY_SESSION_H_
+#define _INVENTORY_SESSION_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "Database.h"
+#include "InventoryFrame.h"
+#include "UHFRecv.h"
+
+/*
+* @brief Inventory session
+* @detail When the reader can not fit every tag in one frame, it answers an
+* inventory command with several frames: all of them but the last one have 
+* status `ERR_INV_FRAME_OUT`. An `InventorySession` receives every frame of 
+* one inventory command, checks their CRC, and merges the cards of each
+* frame straight into the database (see `InventoryFrame.h`).
+*
+* @example
+* ```
+*     if (!session->isBusy())
+*         session->start(cmd, sizeCmd);
+*     
+*     if (session->poll() == STATUS_SUCCESS)
+*         database->printToKeyboard();
+* ```
+*/
+class InventorySession
+{
+public:
+    /**
+    * @brief Constructor
+    * @param
+    * - uhf: UHF receiver used to send the inventory command.
+    * - database: database which the inventoried cards are stored to.
+    */
+    InventorySession(UHFRecv& uhf, Database& database);
+
+    /**
+    * @brief Start a new inventory session (non-blocking)
+    *
+    * @param
+    * - request: inventory command (see `UHFRecv::setCommand()`)
+    * - size: size of request array
+    *
+    * @return
+    * - STATUS_SUCCESS: the session is started.
+    * - STATUS_RS485_BUSY: the previous session is still in progress.
+    */
+    Status start(const byte* request, size_t size);
+
+    /**
+    * @brief Start a new inventory session with a command stored in flash
+    * @detail Same as start(), e.g. with `InventoryCommand<...>::frame` (see
+    * `Command.h`).
+    *
+    * @param
+    * - request: inventory command (PROGMEM)
+    * - size: size of request array
+    *
+    * @return see start()
+    */
+    Status start_P(const byte* request, size_t size);
+
+    /**
+    * @brief Advance the session (non-blocking)
+    * @detail Call this function from `loop()`.
+    *
+    * @param none
+    *
+    * @return
+    * - STATUS_SUCCESS: every frame is received, cards are stored to database.
+    * - STATUS_RS485_BUSY: the session is not finished yet.
+    * - ERR_CRC: a frame fails the checksum test. The cards of the previous
+    *   frames are already stored to database, the session is finished.
+    * - ERR_READ_RS485: there is no session in progress.
+    * - For other values returned from this functions, see 
+    *   `UHFRecv::receive()` and `InventoryFrame::getStatus()`.
+    */
+    Status poll();
+
+    /* Return true if a session is in progress */
+    bool isBusy();
+
+    /* Get number of frames received in the current (or last) session */
+    const byte getNumFrames();
+
+    /* Get the status byte of the last frame (e.g. `ERR_INV_TIMEOUT`) */
+    Status getFrameStatus();
+
+private:
+    /* Start the session once its request is sent, see start() */
+    Status _begin(Status status);
+
+    /* Finish the session */
+    Status _finish(Status status);
+
+    UHFRecv& _uhf;
+    Database& _database;
+
+    byte _numFrames;
+    byte _frameStatus; //< Status byte of the last frame
+    bool _isActive;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "KeyboardScheduler.h"
+
+/* Default constructor */
+KeyboardScheduler::KeyboardScheduler()
+{
+    _burstGap = KEYBOARD_TOKEN_GAP;
+    _keyGap = KEYBOARD_KEY_GAP;
+    _keysPerRun = KEYBOARD_KEYS_PER_RUN;
+    _tokensPerBurst = KEYBOARD_TOKENS_PER_BURST;
+    _separator = KEYBOARD_SEPARATOR;
+
+    _isPausing = false;
+    _numBurstTokens = 0;
+    _lastKey = 0;
+    _lastToken = 0;
+
+    _numBusyKeys = 0;
+    _busySince = 0;
+    _keysPerSecond = 0;
+    _numQueued = 0;
+    _numTyped = 0;
+}
+
+/**
+* @public
+* @brief Set pacing of keystrokes
+*/
+void KeyboardScheduler::setPacing(const uint16_t burstGap, const uint16_t keyGap,
+                                  const byte keysPerRun)
+{
+    _burstGap = burstGap;
+    _keyGap = keyGap;
+    _keysPerRun = (keysPerRun > 0) ? keysPerRun : 1;
+}
+
+/**
+* @public
+* @brief Set bursts of tokens
+*/
+void KeyboardScheduler::setBurst(const byte tokensPerBurst, const char separator)
+{
+    _tokensPerBurst = (tokensPerBurst > 0) ? tokensPerBurst : 1;
+    _separator = separator;
+}
+
+/**
+* @public
+* @brief Queue a token to be typed
+*/
+Status KeyboardScheduler::enqueue(const char* token)
+{
+    size_t size = strlen(token);
+
+    // Token and its separator
+    if (size + 1 > (size_t)(_buffer.getCapacity() - _buffer.getSize()))
+        return ERR_QUEUE_FULL;
+
+    for (size_t i = 0; i < size; i++)
+        _buffer.enqueue(token[i]);
+    _buffer.enqueue('\0'); //< Typed as the separator (see run())
+    _numQueued++;
+
+    return STATUS_SUCCESS;
+}
+
+/**
+* @public
+* @brief Type the queued tokens (non-blocking)
+*/
+void KeyboardScheduler::run()
+{
+    if (_isPausing) {
+        if ((millis() - _lastToken) < _burstGap)
+            return;
+        _isPausing = false;
+    }
+
+    for (byte i = 0; (i < _keysPerRun) && !_buffer.isEmpty(); i++) {
+        if ((_keyGap > 0) && ((micros() - _lastKey) < _keyGap))
+            return;
+
+        char key = _buffer.front();
+        _buffer.dequeue();
+        bool isTokenEnd = (key == '\0');
+
+        if (_numBusyKeys == 0) { //< The queue was empty
+            _busySince = micros();
+            if ((millis() - _lastToken) >= _burstGap)
+                _numBurstTokens = 0; //< The host has rested, new burst
+        }
+        Keyboard.write(isTokenEnd ? _separator : key);
+        _lastKey = micros();
+        _numBusyKeys++;
+
+        // The queue is typed (or the count would overflow): update the rate
+        if (_buffer.isEmpty() || (_numBusyKeys == UINT16_MAX)) {
+            // 1 s = 15625 * 64 us, so that keystrokes * 15625 fits 32 bits.
+            // Keep the previous rate if it took less than one tick of 64 us.
+            uint32_t elapsed = (_lastKey - _busySince) / 64;
+            if (elapsed > 0) {
+                uint32_t rate = (uint32_t)_numBusyKeys * 15625 / elapsed;
+                _keysPerSecond = (rate < UINT16_MAX) ? rate : UINT16_MAX;
+            }
+            _numBusyKeys = 0;
+        }
+
+        if (isTokenEnd) {
+            _numTyped++;
+            _lastToken = millis();
+            if (++_numBurstTokens >= _tokensPerBurst) { //< End of a burst
+                _numBurstTokens = 0;
+                _isPausing = true;
+                return;
+            }
+        }
+    }
+}
+
+/* Return true if every queued token has been typed */
+bool KeyboardScheduler::isIdle()
+{
+    return _buffer.isEmpty();
+}
+
+/* Get number of tokens queued so far (wraps around) */
+uint16_t KeyboardScheduler::getNumQueued()
+{
+    return _numQueued;
+}
+
+/**
+* @public
+* @brief Get number of tokens typed so far
+*/
+uint16_t KeyboardScheduler::getNumTyped()
+{
+    return _numTyped;
+}
+
+/**
+* @public
+* @brief Get the rate of keystrokes achieved
+*/
+uint16_t KeyboardScheduler::getKeysPerSecond()
+{
+    return _keysPerSecond;
+}
@@ -0,0 +1,141 @@
+#ifndef _KEYBOARD_SCHEDULER_H_
+#define _KEYBOARD_SCHEDULER_H_
+
+#include <Arduino.h>
+#include <Keyboard.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "CQueue.h"
+
+/*
+* @brief Non-blocking keyboard output
+* @detail Tokens (e.g. hashed TIDs) are queued, then typed a few keystrokes 
+* at a time every time run() is called from `loop()`. Therefore, inventory 
+* sessions keep running while a burst of cards is being typed, instead of 
+* being blocked by `delay()`.
+*
+* - Every token is followed by a separator key (default: new line, Enter).
+* - Tokens are typed in bursts of up to `tokensPerBurst` tokens, back to back.
+*   `burstGap` (ms) is the pause after each burst, a burst also ends when
+*   nothing is typed for `burstGap`. `keyGap` (us) is the pause after each
+*   keystroke. `keysPerRun` limits the time spent in run(). Tune them to what
+*   the host accepts: the defaults (1 token per burst, 800 ms) suit the
+*   slowest hosts.
+* - getKeysPerSecond() reports the rate achieved, e.g. to tune the pacing.
+*
+* @example
+* ```
+*     void loop()
+*     {
+*         keyboard.run(); //< Call it in every loop(), before any `return`
+*         ...
+*         keyboard.enqueue("CSERR");
+*     }
+* ```
+*/
+class KeyboardScheduler
+{
+public:
+    /**
+    * Default constructor:
+    * - Burst gap: `KEYBOARD_TOKEN_GAP` ms
+    * - Key gap: `KEYBOARD_KEY_GAP` us
+    * - Keys per run: `KEYBOARD_KEYS_PER_RUN`
+    * - Tokens per burst: `KEYBOARD_TOKENS_PER_BURST`
+    * - Separator: `KEYBOARD_SEPARATOR`
+    */
+    KeyboardScheduler();
+
+    /**
+    * @brief Set pacing of keystrokes
+    * @param
+    * - burstGap: time (ms) between 2 bursts of tokens.
+    * - keyGap: time (us) between 2 keystrokes.
+    * - keysPerRun: maximum number of keystrokes typed per run() (at least 1).
+    * @return none
+    */
+    void setPacing(const uint16_t burstGap, const uint16_t keyGap, 
+                   const byte keysPerRun);
+
+    /**
+    * @brief Set bursts of tokens
+    * @detail e.g. `setBurst(8, '\t')` types up to 8 tokens, each followed by
+    * Tab (to move to the next field of a form), before pausing.
+    * @param
+    * - tokensPerBurst: maximum number of tokens typed back to back (at least
+    *   1).
+    * - separator: key typed after each token (e.g. `'\n'`, `'\t'`, `','`).
+    * @return none
+    */
+    void setBurst(const byte tokensPerBurst, const char separator);
+
+    /**
+    * @brief Queue a token to be typed
+    * @param
+    * - token: null-terminated string, it is copied.
+    * @return
+    * - STATUS_SUCCESS: the whole token is queued.
+    * - ERR_QUEUE_FULL: not enough space for the token, nothing is queued.
+    */
+    Status enqueue(const char* token);
+
+    /**
+    * @brief Type the queued tokens (non-blocking)
+    * @detail Types up to `keysPerRun` keystrokes which are due, then returns.
+    * @param none
+    * @return none
+    */
+    void run();
+
+    /* Return true if every queued token has been typed */
+    bool isIdle();
+
+    /* Get number of tokens queued so far (wraps around) */
+    uint16_t getNumQueued();
+
+    /**
+    * @brief Get number of tokens typed so far
+    * @detail A token is typed once its separator is typed. Tokens are typed
+    * in the order they are queued: the token queued when getNumQueued() was
+    * `n` is typed once `(int16_t)(getNumTyped() - n) > 0`.
+    * @param none
+    * @return number of tokens typed (wraps around)
+    */
+    uint16_t getNumTyped();
+
+    /**
+    * @brief Get the rate of keystrokes achieved
+    * @detail Keystrokes typed divided by the time taken, from the first
+    * keystroke typed while the queue was empty to the last keystroke of the
+    * queue (pauses included). Only queues typed in more than 64 us count
+    * (e.g. not a single keystroke).
+    * @param none
+    * @return keystrokes per second of the last time the queue was typed, 0
+    * if it has never been typed in more than 64 us
+    */
+    uint16_t getKeysPerSecond();
+
+private:
+    CQueue<char, KEYBOARD_BUFFER_SIZE, uint16_t> _buffer; //< Queued keystrokes,
+                                                          //  '\0' ends a token
+    uint16_t _burstGap; //< ms
+    uint16_t _keyGap; //< us
+    byte _keysPerRun;
+    byte _tokensPerBurst;
+    char _separator;
+
+    bool _isPausing; //< true if waiting `_burstGap` after a burst
+    byte _numBurstTokens; //< tokens typed in the current burst
+    uint32_t _lastKey; //< micros() of the last keystroke
+    uint32_t _lastToken; //< millis() of the end of the last token
+
+    uint16_t _numBusyKeys; //< keystrokes typed since the queue was empty
+    uint32_t _busySince; //< micros() of the first of them
+    uint16_t _keysPerSecond; //< rate of the last time the queue was typed
+    uint16_t _numQueued; //< tokens queued so far
+    uint16_t _numTyped; //< tokens typed so far
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "PollController.h"
+
+/* Default constructor */
+PollController::PollController()
+{
+    _minPeriod = POLL_MIN_PERIOD;
+    _maxPeriod = POLL_MAX_PERIOD;
+    _patience = POLL_PATIENCE;
+    _shift = POLL_BACKOFF_SHIFT;
+
+    _period = _minPeriod;
+    _numEmpty = 0;
+    _numFailures = 0;
+    _lastEnd = 0;
+}
+
+/**
+* @public
+* @brief Set the range of the period
+*/
+void PollController::setLimits(const uint16_t minPeriod, const uint16_t maxPeriod)
+{
+    _minPeriod = minPeriod;
+    _maxPeriod = (maxPeriod > minPeriod) ? maxPeriod : minPeriod;
+    _setPeriod(_period);
+}
+
+/**
+* @public
+* @brief Set how fast the period backs off when the field is empty
+*/
+void PollController::setAggressiveness(const byte patience, const byte shift)
+{
+    _patience = patience;
+    _shift = (shift < 16) ? shift : 15;
+}
+
+/* Return true if the next inventory command is due */
+bool PollController::isDue()
+{
+    return (millis() - _lastEnd) >= _period;
+}
+
+/**
+* @public
+* @brief Adapt the period to the outcome of a session
+*/
+void PollController::update(const Status status, const uint16_t newCards)
+{
+    if (status == STATUS_RS485_BUSY)
+        return; //< The session is not finished
+
+    _lastEnd = millis();
+
+    if ((status == STATUS_SUCCESS) || (status == ERR_INV_TIMEOUT)
+        || (status == ERR_INV_FRAME_OUT) || (status == ERR_INV_MEM_OUT)) {
+        _numEmpty = 0;
+        _numFailures = 0;
+
+        // Cards are arriving, or the reader could not report every tag
+        if ((newCards > 0) || (status != STATUS_SUCCESS))
+            _setPeriod(_minPeriod);
+        else
+            _setPeriod((uint32_t)_period + (_period >> 3) + 1);
+        return;
+    }
+
+    if (status == ERR_INV_NO_CARD) {
+        _numFailures = 0;
+        if (_numEmpty < 0xFF)
+            _numEmpty++;
+
+        // Keep polling fast for a while, the next person may be close behind
+        if (_numEmpty > _patience)
+            _setPeriod((uint32_t)_period + (_period >> _shift) + 1);
+        return;
+    }
+
+    // Bus or radio errors (e.g. ERR_CRC, ERR_RS485_TIMEOUT): retry at once,
+    // then back off, so a noisy bus is not flooded
+    if (_numFailures < 0xFF)
+        _numFailures++;
+    if (_numFailures == 1)
+        _setPeriod(_minPeriod);
+    else
+        _setPeriod(2 * (uint32_t)_period + 1);
+}
+
+/* Get the current period (ms) */
+uint16_t PollController::getPeriod()
+{
+    return _period;
+}
+
+/**
+* @private
+* @brief Set the period, clamped to the limits
+*/
+void PollController::_setPeriod(uint32_t period)
+{
+    if (period < _minPeriod)
+        period = _minPeriod;
+    if (period > _maxPeriod)
+        period = _maxPeriod;
+    _period = (uint16_t)period;
+}
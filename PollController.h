@@ -0,0 +1,110 @@
+#ifndef _POLL_CONTROLLER_H_
+#define _POLL_CONTROLLER_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+
+/*
+* @brief Adaptive time between inventory commands
+* @detail The time from the end of an inventory session to the start of the
+* next one (period) follows the outcome of the recent sessions:
+*
+* +--------------------------+-----------------------------------------------+
+* | Outcome (update())       | Period                                        |
+* +--------------------------+-----------------------------------------------+
+* | New cards arrived        | minimum: people are walking through           |
+* | ERR_INV_TIMEOUT or       | minimum: the reader could not report every    |
+* | ERR_INV_MEM_OUT          | tag, ask again at once                        |
+* | Known cards only         | grows slowly (by 1/8 of the period)           |
+* | ERR_INV_NO_CARD          | after `patience` empty sessions in a row,     |
+* |                          | grows by 1/2^`shift` of the period            |
+* | ERR_CRC, time-outs, etc. | first failure: minimum (retry at once), then  |
+* |                          | doubles on every failure in a row             |
+* +--------------------------+-----------------------------------------------+
+*
+* The period always stays in [minPeriod, maxPeriod]. The defaults (see
+* `attribute.h`) poll every `POLL_MIN_PERIOD` ms while cards arrive and back
+* off to `POLL_MAX_PERIOD` ms when nobody is there.
+*
+* @example
+* ```
+*     if (!session->isBusy() && rate.isDue()) {
+*         arrivals = database->getNumArrivals();
+*         session->start(cmd, sizeCmd);
+*     }
+*
+*     Status status = session->poll();
+*     if (status == STATUS_SUCCESS)
+*         status = session->getFrameStatus(); //< e.g. ERR_INV_TIMEOUT
+*     if (status != STATUS_RS485_BUSY)
+*         rate.update(status, database->getNumArrivals() - arrivals);
+* ```
+*/
+class PollController
+{
+public:
+    /**
+    * Default constructor:
+    * - Periods: `POLL_MIN_PERIOD` to `POLL_MAX_PERIOD` ms
+    * - Aggressiveness: `POLL_PATIENCE` empty sessions, shift of
+    *   `POLL_BACKOFF_SHIFT`
+    */
+    PollController();
+
+    /**
+    * @brief Set the range of the period
+    * @param
+    * - minPeriod: shortest time (ms) between 2 sessions (fastest rate).
+    * - maxPeriod: longest time (ms) between 2 sessions (slowest rate).
+    * @return none
+    */
+    void setLimits(const uint16_t minPeriod, const uint16_t maxPeriod);
+
+    /**
+    * @brief Set how fast the period backs off when the field is empty
+    * @param
+    * - patience: number of `ERR_INV_NO_CARD` sessions in a row before
+    *   backing off (larger: keeps polling fast longer after the last card).
+    * - shift: the period grows by period / 2^shift per empty session (0:
+    *   doubles, larger: backs off slower).
+    * @return none
+    */
+    void setAggressiveness(const byte patience, const byte shift);
+
+    /* Return true if the next inventory command is due */
+    bool isDue();
+
+    /**
+    * @brief Adapt the period to the outcome of a session
+    * @param
+    * - status: return value of `InventorySession::poll()`, or the status of 
+    *   the last frame (`InventorySession::getFrameStatus()`) if it is
+    *   `STATUS_SUCCESS`.
+    * - newCards: number of cards which arrived in the session (see
+    *   `Database::getNumArrivals()`).
+    * @return none
+    */
+    void update(const Status status, const uint16_t newCards);
+
+    /* Get the current period (ms) */
+    uint16_t getPeriod();
+
+private:
+    /* Set the period, clamped to the limits */
+    void _setPeriod(uint32_t period);
+
+    uint16_t _minPeriod;
+    uint16_t _maxPeriod;
+    byte _patience;
+    byte _shift;
+
+    uint16_t _period;
+    byte _numEmpty; //< ERR_INV_NO_CARD sessions in a row
+    byte _numFailures; //< Bus or radio errors in a row
+    uint32_t _lastEnd; //< millis() of the end of the last session
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef _SESSION_FILTER_H_
+#define _SESSION_FILTER_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "TidKey.h"
+
+/*
+* @brief TIDs already merged in the current inventory session
+* @detail A frame, or the frames of a multi-frame session, may report the same
+* TID several times. The filter remembers the slot of the last card merged to
+* each of its entries (direct-mapped by the hash of the packed TID, see
+* `TidKey.h`), so a repeat is found with one compare against the database
+* array and is dropped before the database lookup.
+*
+* - There is no false positive: a TID is only a repeat if it is equal to the
+*   TID of the card in its entry. A repeat whose entry was taken by another
+*   TID is simply merged again (same result, slower).
+* - Size: number of entries, must be a power of two.
+* - Slot: data type of slot numbers (`byte` for up to 255 cards), the size of
+*   an entry.
+*
+* @note
+* Clear the filter before a slot of the database array is given to another
+* card (e.g. when cards expire).
+*/
+template <size_t Size, typename Slot = byte>
+class SessionFilter
+{
+public:
+    static const Slot NONE = (Slot)~(Slot)0; //< Empty entry
+
+    /**
+    * @brief Constructor
+    * @param
+    * - cards: database array which the slots refer to.
+    */
+    SessionFilter(const Card* cards): _cards(cards)
+    {
+        clear();
+    }
+
+    /* Forget every TID (start of a session) */
+    void clear()
+    {
+        for (size_t i = 0; i < Size; i++)
+            _slots[i] = NONE;
+    }
+
+    /**
+    * @brief Check a TID
+    * @param
+    * - key: packed TID.
+    * @return true if the TID has been remembered since clear()
+    */
+    bool isRepeat(const TidKey key) const
+    {
+        Slot slot = _slots[_home(key)];
+        return (slot != NONE) && isSameTid(packTid(_cards[slot].tid), key);
+    }
+
+    /**
+    * @brief Remember a TID merged to the database
+    * @param
+    * - key: packed TID.
+    * - slot: slot of its card in the database array.
+    * @return none
+    */
+    void insert(const TidKey key, const Slot slot)
+    {
+        _slots[_home(key)] = slot;
+    }
+
+private:
+    /* Entry of a TID */
+    static size_t _home(const TidKey key)
+    {
+        return hashTid(key) & (Size - 1);
+    }
+
+    const Card* _cards;
+    Slot _slots[Size];
+
+    static_assert((Size & (Size - 1)) == 0,
+                  "Size of SessionFilter must be a power of two");
+};
+
+#endif
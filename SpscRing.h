@@ -0,0 +1,189 @@
+#ifndef _SPSC_RING_H_
+#define _SPSC_RING_H_
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "attribute.h"
+
+#if !defined(ARDUINO)
+    #include <atomic>
+#endif
+
+/*
+* @brief Lock-free single-producer/single-consumer ring
+* @detail Unlike `CQueue`, one context may enqueue while another one dequeues,
+* without masking interrupts or locking:
+* - AVR/Arduino: the producer is an interrupt (e.g. USART RX or pin change
+*   interrupt), the consumer is `loop()`. Indices are 1 byte, so loading and
+*   storing them is atomic; compiler barriers make sure an element is written
+*   (read) before its index is published.
+* - Host: the producer and the consumer are 2 threads, indices are
+*   `std::atomic` with acquire/release ordering.
+*
+* - T: data type of elements (e.g. byte for raw serial bytes, Card for tags).
+* - Capacity: maximum number of elements, must be a power of two.
+* - Index: data type of the free-running indices (must be `byte` on AVR).
+*
+* @note
+* Exactly one context may call enqueue() and exactly one context may call
+* dequeue(). Other functions are safe to call from both.
+*
+* @example
+* ```
+*     SpscRing<byte, 64> rxBytes;
+*
+*     ISR(USART1_RX_vect)
+*     {
+*         rxBytes.enqueue(UDR1); //< Producer (interrupt)
+*     }
+*
+*     void loop()
+*     {
+*         byte data;
+*         while (rxBytes.dequeue(data) == STATUS_SUCCESS) //< Consumer
+*             process(data);
+*     }
+* ```
+*/
+template <typename T, size_t Capacity, typename Index = byte>
+class SpscRing
+{
+public:
+    SpscRing()
+    {
+        _store(_head, 0);
+        _store(_tail, 0);
+    }
+
+    /**
+    * @brief Enqueue data (producer only)
+    * @param
+    *    - data: data (const) need to be enqueued
+    * @return
+    *    - STATUS_SUCCESS: Enqueue data successfully.
+    *    - ERR_QUEUE_FULL: the ring is full, can not enqueue anymore.
+    */
+    Status enqueue(const T& data)
+    {
+        Index tail = _loadRelaxed(_tail);
+        if ((Index)(tail - _loadAcquire(_head)) == (Index)Capacity)
+            return ERR_QUEUE_FULL;
+
+        _data[tail & _MASK] = data;
+        _storeRelease(_tail, (Index)(tail + 1)); //< Publish the element
+
+        return STATUS_SUCCESS;
+    }
+
+    /**
+    * @brief Dequeue the oldest element (consumer only)
+    * @param[out]
+    *    - data: the dequeued element
+    * @return
+    *    - STATUS_SUCCESS: Dequeue data successfully.
+    *    - ERR_QUEUE_EMPTY: the ring is empty, can not dequeue anymore.
+    */
+    Status dequeue(T& data)
+    {
+        Index head = _loadRelaxed(_head);
+        if (head == _loadAcquire(_tail))
+            return ERR_QUEUE_EMPTY;
+
+        data = _data[head & _MASK];
+        _storeRelease(_head, (Index)(head + 1)); //< Release the slot
+
+        return STATUS_SUCCESS;
+    }
+
+    bool isEmpty()
+    {
+        return getSize() == 0;
+    }
+
+    bool isFull()
+    {
+        return getSize() == Capacity;
+    }
+
+    /* Number of elements (a snapshot, it may change right after) */
+    Index getSize()
+    {
+        return (Index)(_loadAcquire(_tail) - _loadAcquire(_head));
+    }
+
+    Index getCapacity()
+    {
+        return Capacity;
+    }
+
+private:
+    enum { _MASK = Capacity - 1 };
+
+#if defined(ARDUINO)
+    typedef volatile Index AtomicIndex;
+
+    static Index _loadRelaxed(AtomicIndex& index)
+    {
+        return index;
+    }
+
+    static Index _loadAcquire(AtomicIndex& index)
+    {
+        Index value = index;
+        __asm__ __volatile__("" ::: "memory"); //< Compiler barrier
+        return value;
+    }
+
+    static void _storeRelease(AtomicIndex& index, Index value)
+    {
+        __asm__ __volatile__("" ::: "memory"); //< Compiler barrier
+        index = value;
+    }
+
+    static void _store(AtomicIndex& index, Index value)
+    {
+        index = value;
+    }
+#else
+    typedef std::atomic<Index> AtomicIndex;
+
+    static Index _loadRelaxed(AtomicIndex& index)
+    {
+        return index.load(std::memory_order_relaxed);
+    }
+
+    static Index _loadAcquire(AtomicIndex& index)
+    {
+        return index.load(std::memory_order_acquire);
+    }
+
+    static void _storeRelease(AtomicIndex& index, Index value)
+    {
+        index.store(value, std::memory_order_release);
+    }
+
+    static void _store(AtomicIndex& index, Index value)
+    {
+        index.store(value, std::memory_order_relaxed);
+    }
+#endif
+
+    AtomicIndex _head; //< Next element to dequeue (written by the consumer)
+    AtomicIndex _tail; //< Next free slot (written by the producer)
+
+    T _data[Capacity];
+
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "Capacity of SpscRing must be a power of two");
+    static_assert((size_t)(Index)~(Index)0 >= Capacity,
+                  "Index of SpscRing is too small to hold its Capacity");
+#if defined(__AVR__)
+    static_assert(sizeof(Index) == 1,
+                  "Index of SpscRing must be 1 byte to be atomic on AVR");
+#endif
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef _STORAGE_H_
+#define _STORAGE_H_
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* @brief Non-volatile storage of bytes
+* @detail Backends of `DatabaseJournal`:
+* - `EepromStorage` (`EepromStorage.h`): EEPROM of the MCU, or the EEPROM
+*   emulated in flash.
+* - `MappedFileStorage` (`extras/host/MappedFileStorage.h`): memory-mapped
+*   file (host only).
+*
+* Writes are not atomic: a reset may leave any prefix of a write() in the
+* storage, `DatabaseJournal` checks everything it reads with CRC-16.
+*/
+class Storage
+{
+public:
+    /* Get number of bytes of the storage */
+    virtual size_t getSize() = 0;
+
+    /**
+    * @brief Read bytes
+    * @param[in]
+    * - address: address of the first byte.
+    * - size: number of bytes.
+    * @param[out]
+    * - data: bytes read.
+    * @return none
+    */
+    virtual void read(const size_t address, byte* data, const size_t size) = 0;
+
+    /**
+    * @brief Write bytes
+    * @param
+    * - address: address of the first byte.
+    * - data: bytes to be written.
+    * - size: number of bytes.
+    * @return none
+    */
+    virtual void write(const size_t address, const byte* data,
+                       const size_t size) = 0;
+
+    /* Make the written bytes durable (e.g. flush caches), no-op by default */
+    virtual void commit() {}
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef _TEXT_BUFFER_H_
+#define _TEXT_BUFFER_H_
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* @brief `Print` into a fixed char buffer
+* @detail Text is formatted with the usual print() functions into a buffer
+* given by the caller (e.g. on the stack), instead of being concatenated into
+* `String`s, so formatting never allocates memory. The text is always
+* null-terminated; characters which do not fit are dropped and isOverflowed()
+* becomes true.
+*
+* @example
+* ```
+*     char buffer[3 * MAX_SIZE_TID + 1];
+*     TextBuffer text(buffer, sizeof(buffer));
+*     printTid(text, packTid(tid));
+*     keyboard.enqueue(text.c_str());
+* ```
+*/
+class TextBuffer: public Print
+{
+public:
+    /**
+    * @brief Constructor
+    * @param
+    * - buffer: array of chars, owned by the caller.
+    * - size: number of chars of `buffer` (text of `size - 1` chars).
+    */
+    TextBuffer(char* buffer, const size_t size): _buffer(buffer), _size(size)
+    {
+        clear();
+    }
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t size) override
+    {
+        size_t room = _size - 1 - _length;
+        if (size > room) {
+            size = room;
+            _isOverflowed = true;
+        }
+        memcpy(_buffer + _length, data, size);
+        _length += size;
+        _buffer[_length] = '\0';
+        return size;
+    }
+    using Print::write;
+
+    /* Remove the text */
+    void clear()
+    {
+        _length = 0;
+        _buffer[0] = '\0';
+        _isOverflowed = false;
+    }
+
+    /* Get the null-terminated text */
+    const char* c_str() const { return _buffer; }
+
+    /* Get number of chars of the text */
+    size_t length() const { return _length; }
+
+    /* Get number of chars which can still be written */
+    size_t getRoom() const { return _size - 1 - _length; }
+
+    /* Return true if chars were dropped since clear() */
+    bool isOverflowed() const { return _isOverflowed; }
+
+private:
+    char* _buffer;
+    size_t _size;
+    size_t _length;
+    bool _isOverflowed;
+};
+
+#endif
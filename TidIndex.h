@@ -0,0 +1,126 @@
+#ifndef _TID_INDEX_H_
+#define _TID_INDEX_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "TidKey.h"
+
+/*
+* @brief Hash index of TIDs
+* @detail Open-addressing (linear probing) hash table which maps a TID to the
+* slot of the card in the database array. The table only stores slot numbers,
+* TIDs are packed (see `TidKey.h`) and compared with the cards in the database
+* array, so lookup, insert and remove are O(1) and allocation-free.
+*
+* - TableSize: number of entries of the table, must be a power of two and
+*   larger than the number of cards (2x is recommended).
+* - Slot: data type of slot numbers (`byte` for up to 255 cards).
+*
+* @note
+* The index must be kept in sync with the database array: remove() a slot
+* before its card is overwritten, insert() it after.
+*/
+template <size_t TableSize, typename Slot = byte>
+class TidIndex
+{
+public:
+    static const Slot NONE = (Slot)~(Slot)0; //< Empty entry / not found
+
+    /**
+    * @brief Constructor
+    * @param
+    * - cards: database array which the slots refer to.
+    */
+    TidIndex(const Card* cards): _cards(cards)
+    {
+        clear();
+    }
+
+    /* Remove every entry */
+    void clear()
+    {
+        for (size_t i = 0; i < TableSize; i++)
+            _table[i] = NONE;
+    }
+
+    /**
+    * @brief Find the slot of a TID
+    * @param
+    * - key: packed TID to be found.
+    * @return slot of the card in the database array, NONE if not found.
+    */
+    Slot find(const TidKey key) const
+    {
+        for (size_t i = _home(key); _table[i] != NONE; i = _next(i)) {
+            if (isSameTid(packTid(_cards[_table[i]].tid), key))
+                return _table[i];
+        }
+        return NONE;
+    }
+
+    /**
+    * @brief Add a slot of the database array to the index
+    * @param
+    * - slot: slot of the card, its TID must not be in the index yet.
+    * @return none
+    */
+    void insert(const Slot slot)
+    {
+        size_t i = _home(packTid(_cards[slot].tid));
+        while (_table[i] != NONE)
+            i = _next(i);
+        _table[i] = slot;
+    }
+
+    /**
+    * @brief Remove a slot of the database array from the index
+    * @param
+    * - slot: slot of the card (the card must not be overwritten yet).
+    * @return none
+    */
+    void remove(const Slot slot)
+    {
+        size_t i = _home(packTid(_cards[slot].tid));
+        while (_table[i] != slot) {
+            if (_table[i] == NONE)
+                return; //< not in the index
+            i = _next(i);
+        }
+
+        // Backward-shift deletion: move the following entries of the probe
+        // sequence back, so no tombstone is needed.
+        size_t hole = i;
+        for (i = _next(i); _table[i] != NONE; i = _next(i)) {
+            size_t home = _home(packTid(_cards[_table[i]].tid));
+            if (((i - home) & _MASK) >= ((i - hole) & _MASK)) {
+                _table[hole] = _table[i];
+                hole = i;
+            }
+        }
+        _table[hole] = NONE;
+    }
+
+private:
+    enum { _MASK = TableSize - 1 };
+
+    static size_t _next(size_t i)
+    {
+        return (i + 1) & _MASK;
+    }
+
+    static size_t _home(const TidKey key)
+    {
+        return hashTid(key) & _MASK;
+    }
+
+    const Card* _cards;
+    Slot _table[TableSize];
+
+    static_assert((TableSize & (TableSize - 1)) == 0,
+                  "TableSize of TidIndex must be a power of two");
+};
+
+#endif
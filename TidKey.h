@@ -0,0 +1,106 @@
+#ifndef _TID_KEY_H_
+#define _TID_KEY_H_
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "attribute.h"
+
+/*
+* @brief Packed TID
+* @detail A TID (up to `MAX_SIZE_TID` = 6 bytes plus its size) packed into a
+* 64-bit integer, so TIDs are compared, hashed and ordered with a few integer
+* instructions instead of being formatted to strings.
+*
+* +--------+--------+--------+--------+--------+--------+--------+--------+
+* | 63..56 | 55..48 | 47..40 | 39..32 | 31..24 | 23..16 | 15..8  |  7..0  |
+* +--------+--------+--------+--------+--------+--------+--------+--------+
+* | byte 0 | byte 1 | byte 2 | byte 3 | byte 4 | byte 5 |   0    |  size  |
+* +--------+--------+--------+--------+--------+--------+--------+--------+
+* - Unused bytes of shorter TIDs are 0.
+* - Comparing 2 keys as integers orders TIDs by their bytes, then by size.
+*/
+typedef uint64_t TidKey;
+
+/**
+* @brief Pack the bytes of a TID
+* @detail e.g. a TID read in place from a response frame (see
+* `InventoryFrame.h`).
+* @param
+* - data: bytes of the TID.
+* - size: number of bytes, must not be larger than `MAX_SIZE_TID`.
+* @return packed TID
+*/
+inline TidKey packTid(const byte* data, const byte size)
+{
+    TidKey key = 0;
+    for (byte i = 0; i < MAX_SIZE_TID; i++) {
+        key <<= 8;
+        if (i < size)
+            key |= data[i];
+    }
+    return (key << 16) | size;
+}
+
+/**
+* @brief Pack a TID
+* @param
+* - tid: TID to be packed, `tid.size` must not be larger than `MAX_SIZE_TID`.
+* @return packed TID
+*/
+inline TidKey packTid(const TID& tid)
+{
+    return packTid(tid.tidByte, tid.size);
+}
+
+/**
+* @brief Unpack a TID
+* @param[in]
+* - key: packed TID.
+* @param[out]
+* - tid: unpacked TID.
+* @return none
+*/
+inline void unpackTid(const TidKey key, TID& tid)
+{
+    tid.size = (byte)key;
+    for (byte i = 0; i < MAX_SIZE_TID; i++)
+        tid.tidByte[i] = (byte)(key >> (56 - 8 * i));
+}
+
+/* Get size of a packed TID */
+inline byte getTidSize(const TidKey key)
+{
+    return (byte)key;
+}
+
+/* Return true if 2 packed TIDs are the same */
+inline bool isSameTid(const TidKey a, const TidKey b)
+{
+    return a == b;
+}
+
+/* Return true if TID `a` is ordered before TID `b` */
+inline bool isTidLess(const TidKey a, const TidKey b)
+{
+    return a < b;
+}
+
+/**
+* @brief Hash of a packed TID
+* @detail 16-bit words are folded first, so AVR only needs 16-bit arithmetic.
+* @param
+* - key: packed TID.
+* @return 16-bit hash
+*/
+inline uint16_t hashTid(const TidKey key)
+{
+    uint16_t hash = (uint16_t)key ^ (uint16_t)(key >> 16)
+                    ^ (uint16_t)(key >> 32) ^ (uint16_t)(key >> 48);
+    hash *= 0x9E37; //< Fibonacci hashing
+    return hash ^ (hash >> 8);
+}
+
+#endif
@@ -1,11 +1,20 @@
 #include "UHFRecv.h"
 
+#include "Instrument.h"
+#include "TextBuffer.h"
+
 /* Default constructor */
 UHFRecv::UHFRecv(): _uhfSerial(Serial1)
 {
     _baudRate = DEFAULT_BAUD_RATE;   //< 57600 bps
     _protocol = DEFAULT_PROTOCOL;    //< 8N1
     _ctlPin = DEFAULT_RS485_CTL_PIN; //< 4
+
+    _timeout = DEFAULT_RX_TIMEOUT;
+    _rxState = _RX_IDLE;
+    _frameSize = 0;
+    _frameCrc = CRC16_INIT;
+    _inventoryCmd[0] = 0; //< No command built yet (see setCommand())
 }
 
 UHFRecv::UHFRecv(HardwareSerial& serial, const long baudRate, const byte ctlPin): 
@@ -14,6 +23,12 @@ UHFRecv::UHFRecv(HardwareSerial& serial, const long baudRate, const byte ctlPin)
     _baudRate = baudRate;
     _ctlPin = ctlPin;
     _protocol = DEFAULT_PROTOCOL;
+
+    _timeout = DEFAULT_RX_TIMEOUT;
+    _rxState = _RX_IDLE;
+    _frameSize = 0;
+    _frameCrc = CRC16_INIT;
+    _inventoryCmd[0] = 0; //< No command built yet (see setCommand())
 }
 
 /* Full customisation for UHFRecv() */
@@ -23,6 +38,12 @@ UHFRecv::UHFRecv(HardwareSerial& serial, const long baudRate,
     _baudRate = baudRate;
     _protocol = protocol;
     _ctlPin = ctlPin;
+
+    _timeout = DEFAULT_RX_TIMEOUT;
+    _rxState = _RX_IDLE;
+    _frameSize = 0;
+    _frameCrc = CRC16_INIT;
+    _inventoryCmd[0] = 0; //< No command built yet (see setCommand())
 }
 
 /**
@@ -46,6 +67,12 @@ byte* UHFRecv::setCommand(const byte readerAddr,
     // see `doc/Protocols` for more commands
     const byte command = 0x01; //< Inventory command
 
+    // The last command is kept: no CRC if the parameters did not change
+    if ((_inventoryCmd[0] == sizeof(_inventoryCmd) - 1)
+        && (_inventoryCmd[1] == readerAddr) && (_inventoryCmd[2] == command)
+        && (_inventoryCmd[3] == addrTid) && (_inventoryCmd[4] == lenTid))
+        return _inventoryCmd;
+
     // size of the command (exclude the size itself)
     _inventoryCmd[0] = sizeof(_inventoryCmd) - 1; 
     
@@ -73,63 +100,219 @@ const size_t UHFRecv::getSizeCommand()
 */
 bool UHFRecv::isDataPreserved(byte* receivedData, size_t size)
 {
-    UHFRecv::Crc reCalCrc = UHFRecv::_calculateCrc(receivedData, size - 2);
-    
-    UHFRecv::Crc receivedCrc = 0x00;
-    
-    if (receivedData[RE_STATUS_INDEX] == ERR_CRC)
+    UHF_SPAN(STAGE_CRC);
+
+    // Len byte excludes itself, the shortest frame is Len, Adr, reCmd, 
+    // Status and CRC (2 bytes)
+    size_t frameSize = (size > RE_LENGTH_INDEX) ? receivedData[RE_LENGTH_INDEX] + 1 : 0;
+    if ((frameSize < RE_DATA_INDEX + 2) || (frameSize > size)
+        || (receivedData[RE_STATUS_INDEX] == ERR_CRC)) {
+        UHF_SPAN_STATUS(ERR_CRC);
         return false;
-    else {
-        // Merge 2 checksum bytes into 16-bit CRC-16
-        byte lowByte = receivedData[size - 2];
-        byte highByte = receivedData[size - 1];
-        if (isLittleEndian())
-            receivedCrc = (lowByte << 8) | highByte;
-        else 
-            receivedCrc = (highByte << 8) | lowByte;
-
-        /* 
-        * If the calculated CRC-16 and the received CRC-16 are not the same, 
-        * then the data from reader to RS485 are not preserved.
-        */
-        return (receivedCrc != reCalCrc) ? false : true; 
     }
+
+    /*
+    * CRC-16 of the whole frame (data and its CRC, low byte first) is 0 if 
+    * the calculated CRC-16 and the received CRC-16 are the same. Otherwise,
+    * the data from reader to RS485 are not preserved.
+    */
+    if (crc16Update(CRC16_INIT, receivedData, frameSize) != 0) {
+        UHF_SPAN_STATUS(ERR_CRC);
+        return false;
+    }
+    return true;
 }
 
 /**
 * @public
-* @brief Get bytes of data from UHF reader
+* @brief Ensure the preservation of the last complete response frame
 */
-Status UHFRecv::getRawData(byte* reData, byte* request, size_t size)
+bool UHFRecv::isDataPreserved()
 {
-    digitalWrite(_ctlPin, RS485_TRANSMIT);
+    UHF_SPAN(STAGE_CRC);
+
+    // `_frameCrc` covers the CRC bytes as well, it is 0 for a valid frame
+    if ((_frameSize < RE_DATA_INDEX + 2) || (_frame[RE_STATUS_INDEX] == ERR_CRC)
+        || (_frameCrc != 0)) {
+        UHF_SPAN_STATUS(ERR_CRC);
+        return false;
+    }
+    return true;
+}
+
+/**
+* @public
+* @brief Send a request to UHF reader (non-blocking)
+*/
+Status UHFRecv::sendRequest(const byte* request, size_t size)
+{
+    if (_rxState != _RX_IDLE)
+        return STATUS_RS485_BUSY;
+
+    _beginRequest(request[RE_ADDRESS_INDEX], request[RE_COMMAND_INDEX]);
     _uhfSerial.write(request, size);
-    delay(10); //< [WARNING] This delay is VERY IMPORTANT
-    digitalWrite(_ctlPin, RS485_RECEIVE);
+    _endRequest(size);
+
+    return STATUS_SUCCESS;
+}
+
+/**
+* @public
+* @brief Send a request stored in flash to UHF reader (non-blocking)
+*/
+Status UHFRecv::sendRequest_P(const byte* request, size_t size)
+{
+    if (_rxState != _RX_IDLE)
+        return STATUS_RS485_BUSY;
+
+    _beginRequest(pgm_read_byte(request + RE_ADDRESS_INDEX),
+                  pgm_read_byte(request + RE_COMMAND_INDEX));
+    for (size_t i = 0; i < size; i++)
+        _uhfSerial.write(pgm_read_byte(request + i));
+    _endRequest(size);
+
+    return STATUS_SUCCESS;
+}
+
+/**
+* @public
+* @brief Receive the response frame (non-blocking)
+*/
+Status UHFRecv::receive()
+{
+    if (_rxState == _RX_IDLE)
+        return ERR_READ_RS485;
+
+    if (_rxState == _RX_TRANSMIT) {
+        if ((micros() - _txStart) < _txTime)
+            return STATUS_RS485_BUSY; //< The request is still on the wire
+
+        digitalWrite(_ctlPin, RS485_RECEIVE);
+        _rxStart = millis();
+        _rxState = _RX_RECEIVE;
+    }
 
-    byte i = 0;
     while (_uhfSerial.available() > 0) {
-        reData[i] = _uhfSerial.read();
-        if (reData[i] < 0) //< return -1 if no data is read
-            return ERR_READ_RS485;
-        i++;
+        byte size = _frameSize;
+        _frame[_frameSize++] = _uhfSerial.read();
+        _resync();
+
+        // Update the CRC-16 with the new byte. If garbage bytes were dropped,
+        // the frame starts elsewhere: calculate it again (rare).
+        if (_frameSize == size + 1)
+            _frameCrc = crc16Update(_frameCrc, _frame + size, 1);
+        else
+            _frameCrc = crc16Update(CRC16_INIT, _frame, _frameSize);
+
+        // Len byte excludes itself
+        if ((_frameSize > RE_LENGTH_INDEX) 
+            && (_frameSize == _frame[RE_LENGTH_INDEX] + 1)) {
+            _rxState = _RX_IDLE;
+            UHF_SPAN_RECORD(STAGE_SERIAL, _txStart, STATUS_SUCCESS);
+            return STATUS_SUCCESS;
+        }
+    }
+
+    if ((millis() - _rxStart) >= _timeout) {
+        _rxState = _RX_IDLE;
+        _frameSize = 0;
+        _frameCrc = CRC16_INIT;
+        UHF_SPAN_RECORD(STAGE_SERIAL, _txStart, ERR_RS485_TIMEOUT);
+        return ERR_RS485_TIMEOUT;
     }
     
-    delay(2); //< [WARNING] This delay is VERY IMPORTANT
+    return STATUS_RS485_BUSY;
+}
+
+/**
+* @public
+* @brief Wait for one more response frame without sending a request
+*/
+Status UHFRecv::listen()
+{
+    if (_rxState != _RX_IDLE)
+        return STATUS_RS485_BUSY;
+
+    // Bytes of the next frame may already be in the serial buffer, keep them
+    _frameSize = 0;
+    _frameCrc = CRC16_INIT;
+    _rxStart = millis();
+    _rxState = _RX_RECEIVE;
+#if defined(UHF_INSTRUMENT)
+    _txStart = micros(); //< Start of the span of the next frame
+#endif
+
     return STATUS_SUCCESS;
 }
 
+/* Return true if a request is in progress */
+bool UHFRecv::isBusy()
+{
+    return (_rxState != _RX_IDLE);
+}
+
+/* Get the last complete response frame */
+byte* UHFRecv::getFrame()
+{
+    return _frame;
+}
+
+/* Get size of the last complete response frame */
+const size_t UHFRecv::getFrameSize()
+{
+    return _frameSize;
+}
+
+/* Set timeout of a response frame */
+void UHFRecv::setTimeout(const uint16_t timeout)
+{
+    _timeout = timeout;
+}
+
+/**
+* @public
+* @brief Get bytes of data from UHF reader (blocking)
+*/
+Status UHFRecv::getRawData(byte* reData, byte* request, size_t size)
+{
+    Status status = sendRequest(request, size);
+
+    while (status == STATUS_SUCCESS || status == STATUS_RS485_BUSY) {
+        status = receive();
+        if (status == STATUS_SUCCESS) {
+            memcpy(reData, _frame, _frameSize);
+            break;
+        }
+    }
+    return status;
+}
+
 /**
 * @public
 * @brief Debug function - print bytes of data read from RS485 with base
 */
 void UHFRecv::_debugPrintRawData(byte* reData, size_t size, byte base)
 {
-	for (byte i = 0; i < size; i++) {
-		Serial.print(reData[i], base);
-		Serial.print(" ");
-	}
-	Serial.println();
+    // The frame is formatted on the stack and written a line buffer at a
+    // time (once for a frame of up to ~20 bytes in HEX), not byte by byte.
+    char line[DEBUG_LINE_SIZE];
+    TextBuffer text(line, sizeof(line));
+
+    for (size_t i = 0; i < size; i++) {
+        if (text.getRoom() < 8 + 1) { //< A byte in BIN and a space
+            Serial.write(text.c_str(), text.length());
+            text.clear();
+        }
+        text.print(reData[i], base);
+        text.print(" ");
+    }
+
+    if (text.getRoom() < 2) { //< CR LF
+        Serial.write(text.c_str(), text.length());
+        text.clear();
+    }
+    text.println();
+    Serial.write(text.c_str(), text.length());
 }
 
 /**
@@ -138,35 +321,86 @@ void UHFRecv::_debugPrintRawData(byte* reData, size_t size, byte base)
 */
 void UHFRecv::_debugPrintRawData(byte* reData, size_t size)
 {
-    for (byte i = 0; i < size; i++) {
-        Serial.print(reData[i], HEX);
-        Serial.print(" ");
-    }
-    Serial.println();
+    _debugPrintRawData(reData, size, HEX);
 }
 
 /**
 * @private
 * @brief CRC-16 Calculator (polynomial of 0x8408)
+* @detail The engine is selected by `UHF_CRC_ENGINE` (see `Crc16.h`).
 */
-UHFRecv::Crc UHFRecv::_calculateCrc(byte* data, size_t size)
+UHFRecv::Crc UHFRecv::_calculateCrc(const byte* data, size_t size)
 {
-    _crc = 0xFFFF;
-    for (size_t i = 0; i < size; i++) {
-        _crc ^= data[i];
-        for (byte j = 0; j < 8; j++) {
-            if (_crc & 0x0001)
-                _crc = (_crc >> 1) ^ 0x8408; //< Fixed polynomial
-            else
-                _crc = _crc >> 1;
-        }
-    }
+    UHFRecv::Crc crc = crc16Update(CRC16_INIT, data, size);
     
     /* return the result based on the endianess of the system */
     if (isLittleEndian())
-        return _crc >> 8 | _crc << 8;
+        return crc >> 8 | crc << 8;
     else
-        return _crc;
+        return crc;
+}
+
+/**
+* @private
+* @brief Prepare the receiver and the transceiver for a new request
+*/
+void UHFRecv::_beginRequest(const byte address, const byte command)
+{
+    // Drop stale bytes of previous frames
+    while (_uhfSerial.available() > 0)
+        _uhfSerial.read();
+
+    _reqAddr = address;
+    _reqCmd = command;
+    _frameSize = 0;
+    _frameCrc = CRC16_INIT;
+
+    digitalWrite(_ctlPin, RS485_TRANSMIT);
+}
+
+/**
+* @private
+* @brief Start the wire time of a request which has been written
+*/
+void UHFRecv::_endRequest(size_t size)
+{
+    _txStart = micros();
+
+    // Up to 11 bits per byte on the wire (start, 8 data, parity, stop)
+    _txTime = (uint32_t)size * 11000000UL / _baudRate;
+    _rxState = _RX_TRANSMIT;
+}
+
+/**
+* @private
+* @brief Drop garbage bytes at the start of the frame
+*/
+void UHFRecv::_resync()
+{
+    while (_frameSize > 0) {
+        bool isValid = true;
+        byte len = _frame[RE_LENGTH_INDEX];
+
+        // Shortest frame: Len, Adr, reCmd, Status, CRC (2 bytes)
+        if ((len < RE_DATA_INDEX + 1) || (len > INV_MAX_SIZE - 1))
+            isValid = false;
+        
+        // 0xFF is the broadcast address, any reader can answer it
+        if ((_frameSize > RE_ADDRESS_INDEX) && (_reqAddr != 0xFF)
+            && (_frame[RE_ADDRESS_INDEX] != _reqAddr))
+            isValid = false;
+
+        // reCmd is 0x00 for unrecognised commands
+        if ((_frameSize > RE_COMMAND_INDEX) 
+            && (_frame[RE_COMMAND_INDEX] != _reqCmd)
+            && (_frame[RE_COMMAND_INDEX] != 0x00))
+            isValid = false;
+
+        if (isValid)
+            return;
+
+        memmove(_frame, _frame + 1, --_frameSize);
+    }
 }
 
 /** 
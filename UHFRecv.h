@@ -7,6 +7,8 @@
 #include <stdint.h>
 
 #include "attribute.h"
+#include "Command.h"
+#include "Crc16.h"
 
 class UHFRecv
 {
@@ -52,6 +54,9 @@ public:
 
     /**
     * @brief Set command for cards inventory
+    * @detail The command is kept, calling this function again with the same
+    * parameters costs a few compares. For constant parameters, prefer
+    * `InventoryCommand` (see `Command.h`), built at compile time.
     *
     * @param 
     * - readerAddr: reader address (range from 0 - 255, default 0).
@@ -69,28 +74,122 @@ public:
     /**
     * @brief Ensure the preservation of data.
     * @detail This function provides 2 levels of data preservation (between UHF 
-    * card to reader - between UHF reader to RS485).
+    * card to reader - between UHF reader to RS485). The size of the frame is
+    * given by its Len byte, so `receivedData` may be a larger buffer (e.g.
+    * `INV_MAX_SIZE` bytes).
     *
     * @param
     * - receivedData: pointer to array of bytes of received data from RS485
     * - size: number of elements in array.
     *
-    * @return true if the data are preserved, otherwise false.
+    * @return true if the data are preserved, otherwise false (also if the 
+    * frame is larger than `size`).
     */
     bool isDataPreserved(byte* receivedData, size_t size);
 
     /**
-    * @brief Get bytes of data from UHF reader
+    * @brief Ensure the preservation of the last complete response frame
+    * @detail Same as isDataPreserved(byte*, size_t) for getFrame(), but the 
+    * CRC-16 is updated by receive() as each byte arrives: this check is a
+    * compare only.
+    *
+    * @param none
+    *
+    * @return true if the data are preserved, otherwise false.
+    */
+    bool isDataPreserved();
+
+    /**
+    * @brief Send a request to UHF reader (non-blocking)
+    * @detail The RS485 transceiver is switched back to receive mode by
+    * receive() as soon as the request has left the wire (no delay()).
+    *
+    * @param
+    * - request: array of request to be sent to UHF reader
+    * - size: size of request array
+    *
+    * @return
+    * - STATUS_SUCCESS: the request is being sent.
+    * - STATUS_RS485_BUSY: the previous request is still in progress.
+    */
+    Status sendRequest(const byte* request, size_t size);
+
+    /**
+    * @brief Send a request stored in flash to UHF reader (non-blocking)
+    * @detail Same as sendRequest(), `request` is in program memory on AVR 
+    * (e.g. `InventoryCommand<...>::frame`, see `Command.h`).
+    *
+    * @param
+    * - request: array of request to be sent to UHF reader (PROGMEM)
+    * - size: size of request array
+    *
+    * @return see sendRequest()
+    */
+    Status sendRequest_P(const byte* request, size_t size);
+
+    /**
+    * @brief Receive the response frame (non-blocking)
+    * @detail Call this function from `loop()` (or `serialEvent1()`). It only
+    * reads the bytes which are already available, uses the Len byte to know 
+    * when the frame is complete and skips garbage bytes until a valid frame
+    * header is found.
+    *
+    * @param none
+    *
+    * @return
+    * - STATUS_SUCCESS: a complete frame is received (see getFrame()).
+    * - STATUS_RS485_BUSY: the frame is not complete yet.
+    * - ERR_RS485_TIMEOUT: no complete frame within the timeout.
+    * - ERR_READ_RS485: there is no request in progress.
+    */
+    Status receive();
+
+    /**
+    * @brief Wait for one more response frame without sending a request
+    * @detail Used when the reader answers a request with several frames 
+    * (status `ERR_INV_FRAME_OUT`). Call receive() to get the next frame.
+    *
+    * @param none
+    *
+    * @return
+    * - STATUS_SUCCESS: the receiver is waiting for the next frame.
+    * - STATUS_RS485_BUSY: the previous request is still in progress.
+    */
+    Status listen();
+
+    /* Return true if a request is in progress (sent, but not answered yet) */
+    bool isBusy();
+
+    /* Get the last complete response frame */
+    byte* getFrame();
+
+    /* Get size of the last complete response frame (Len byte + 1) */
+    const size_t getFrameSize();
+
+    /**
+    * @brief Set timeout of a response frame
+    * @param
+    * - timeout: time (ms) from the end of the request to the end of the 
+    *   response frame (default: `DEFAULT_RX_TIMEOUT`).
+    * @return none
+    */
+    void setTimeout(const uint16_t timeout);
+
+    /**
+    * @brief Get bytes of data from UHF reader (blocking)
+    * @detail Wrapper of sendRequest() and receive(), it returns as soon as
+    * the response frame is complete. Prefer sendRequest() and receive() in 
+    * `loop()`, so the MCU is free while bytes are on the wire.
     *
     * @param[in]
     * - request: array of request to be sent to UHF reader
     * - size: size of request array
     * @param[out]
-    * - reData: response array is stored in reData
+    * - reData: response array is stored in reData (at least `INV_MAX_SIZE`)
     *
     * @return
-    * - STATUS_SUCCESS: successfully get bytes of data from SDM120
-    * - ERR_READ_RS485: no read data from RS485. 
+    * - STATUS_SUCCESS: successfully get bytes of data from UHF reader
+    * - ERR_RS485_TIMEOUT: no complete frame within the timeout.
     */
     Status getRawData(byte* reData, byte* request, size_t size);
 
@@ -121,6 +220,8 @@ public:
 private:
     /**
     * @brief CRC-16 Calculator (polynomial of 0x8408)
+    * @detail See `Crc16.h` to select the CRC engine (bitwise, nibble-table,
+    * byte-table or slicing-by-4).
     *
     * @param
     * - data: array of bytes of data needed to calculate checksum.
@@ -128,8 +229,28 @@ private:
     *
     * @return 16 bits of CRC-16 checksum
     */
-	Crc _calculateCrc(byte* data, size_t size);
-    Crc _crc;
+    Crc _calculateCrc(const byte* data, size_t size);
+
+    /* Drop stale bytes, reset the receiver and switch to transmit mode */
+    void _beginRequest(const byte address, const byte command);
+
+    /* Start the wire time of a request of `size` bytes, which is written */
+    void _endRequest(size_t size);
+
+    /**
+    * @brief Drop bytes at the start of `_frame` until it starts with a valid
+    * header (Len, Adr and reCmd of the pending request).
+    * @param none
+    * @return none
+    */
+    void _resync();
+
+    /* States of the frame receiver */
+    enum ReceiverState: byte {
+        _RX_IDLE,     //< No request in progress
+        _RX_TRANSMIT, //< Request is being transmitted
+        _RX_RECEIVE   //< Waiting for the response frame
+    };
 
     // Config
     long _baudRate;
@@ -138,6 +259,18 @@ private:
     HardwareSerial& _uhfSerial;
 
     byte _inventoryCmd[7]; //< Size of inventory command is 7 bytes
+
+    // Frame receiver
+    byte _rxState;
+    byte _frame[INV_MAX_SIZE]; //< Response frame
+    byte _frameSize; //< Number of bytes of `_frame` received so far
+    uint16_t _frameCrc; //< CRC-16 of the bytes of `_frame` received so far
+    byte _reqAddr; //< Reader address of the pending request
+    byte _reqCmd; //< Command of the pending request
+    uint16_t _timeout; //< Response frame timeout (ms)
+    uint32_t _txStart; //< micros() when the request was sent
+    uint32_t _txTime; //< Time on the wire (us) of the request
+    uint32_t _rxStart; //< millis() when the request left the wire
 };
 
 /** 
@@ -9,6 +9,35 @@
 #define MAX_CARDS                    15 //< Maximum number of cards can be 
                                         //  inventoried at once
 #define EXPIRE_TIME                  5000
+
+#define KEYBOARD_TOKEN_GAP           800 //< Time (ms) between 2 bursts of
+                                         //  tokens (cards) typed to keyboard
+#define KEYBOARD_TOKENS_PER_BURST    1   //< Maximum number of tokens typed
+                                         //  back to back
+#define KEYBOARD_SEPARATOR           '\n' //< Key typed after each token
+#define KEYBOARD_KEY_GAP             0   //< Time (us) between 2 keystrokes
+#define KEYBOARD_KEYS_PER_RUN        4   //< Maximum number of keystrokes typed
+                                         //  per loop()
+
+#define POLL_MIN_PERIOD              50  //< Time (ms) between 2 inventory 
+                                         //  sessions while cards arrive
+#define POLL_MAX_PERIOD              1000 //< Time (ms) between 2 inventory
+                                          //  sessions when nobody is there
+#define POLL_PATIENCE                4   //< Empty sessions before backing off
+#define POLL_BACKOFF_SHIFT           1   //< Back-off: period grows by 1/2^shift
+
+#define JOURNAL_BATCH                4   //< Changes of the database written to
+                                         //  EEPROM at once (see
+                                         //  `DatabaseJournal.h`)
+#define JOURNAL_FLUSH_PERIOD         5000 //< Maximum time (ms) a change waits
+                                          //  in RAM before being written
+#define JOURNAL_SYNC_BYTES           8   //< Bytes written to EEPROM per
+                                         //  Database::sync() (3.3 ms each)
+
+#ifndef DATABASE_CAPACITY
+#define DATABASE_CAPACITY            25 //< Maximum number of cards can exist in
+                                        //  the database
+#endif
 /* End of user config */
 
 /* Developer Configuration */
@@ -16,6 +45,12 @@
 #define DEFAULT_BAUD_RATE            57600 //< default baud rate of PK-UHF101
 #define DEFAULT_RS485_CTL_PIN        4 //< RS485 control pin
 #define ANALOG_PIN                   A0 //< Analog pin for seeding random number
+#define DEFAULT_RX_TIMEOUT           300 //< Maximum time (ms) to receive a whole
+                                         //  response frame
+
+// Uncomment to record the time spent in each stage of a poll (see
+// `Instrument.h`), it costs RAM and cycles
+// #define UHF_INSTRUMENT
 
 // Command configuration (see `doc/Protocols`)
 const byte READER_ADDRESS         =  0x00;
@@ -32,6 +67,30 @@ const byte LENGTH_TID             =  3;
                                        //  to maximise number of cards can be 
                                        //  read at once. 
 
+// Size (characters) of a line of debug output, formatted on the stack (see
+// `TextBuffer.h`)
+#ifndef DEBUG_LINE_SIZE
+#define DEBUG_LINE_SIZE              64
+#endif
+
+// Size (characters) of the keyboard output buffer (see `KeyboardScheduler.h`)
+#ifndef KEYBOARD_BUFFER_SIZE
+#define KEYBOARD_BUFFER_SIZE         128
+#endif
+
+// Number of entries of the filter of repeated TIDs in an inventory session
+// (see `SessionFilter.h`), one slot of the database each (1 byte for up to
+// 255 cards). Must be a power of two.
+#ifndef SESSION_FILTER_SIZE
+#define SESSION_FILTER_SIZE          16
+#endif
+
+// Number of entries of the TID hash index of the database (see `TidIndex.h`).
+// Must be a power of two, at least twice the capacity of the database.
+#ifndef TID_INDEX_SIZE
+#define TID_INDEX_SIZE               64
+#endif
+
 #define RS485_TRANSMIT               HIGH
 #define RS485_RECEIVE                LOW
 
@@ -41,6 +100,15 @@ typedef struct {
     byte tidByte[MAX_SIZE_TID];
 } TID;
 
+/* Data type of slots of the database (the largest value means "no slot") */
+#if (DATABASE_CAPACITY < 0xFF)
+typedef byte CardIndex;
+#elif (DATABASE_CAPACITY < 0xFFFF)
+typedef uint16_t CardIndex;
+#else
+typedef uint32_t CardIndex;
+#endif
+
 /* Data type represents UHF Card */
 typedef struct {
     bool status;
@@ -123,7 +191,13 @@ enum Status: byte {
     ERR_QUEUE_FULL     = 0x0A,
     ERR_QUEUE_EMPTY    = 0x0B,
 
-    ERR_READ_RS485     = 0x1A
+    ERR_READ_RS485     = 0x1A,
+
+    // No complete response frame received from RS485 within the timeout
+    ERR_RS485_TIMEOUT  = 0x1B,
+
+    // A request is in progress, the response frame is not complete yet
+    STATUS_RS485_BUSY  = 0x1C
 };
 
 #endif
@@ -20,6 +20,9 @@ UHFRecv TictagUhf(Serial1, BAUD_RATE, RS485_CONTROL);
 // UHFRecv can also be instantiated like this
 // UHFRecv TictagUhf(Serial1, BAUD_RATE, SERIAL_8N1, RS485_CONTROL);
 
+// Inventory command, built at compile time and stored in flash (see `Command.h`)
+typedef InventoryCommand<READER_ADDRESS, TID_ARRESSS, LENGTH_TID> Inventory;
+
 uint32_t now = 0;
 uint32_t period = 1000; //< Change this value to modify time between inventory
                        //  sessions (600 means 600 ms).
@@ -58,15 +61,21 @@ void loop()
 {
     Status status = 0x00;
 
-    byte reData[INV_MAX_SIZE] = {0};
-    
-    byte* cmd = TictagUhf.setCommand(READER_ADDRESS, TID_ARRESSS, LENGTH_TID);
-    size_t sizeCmd = TictagUhf.getSizeCommand();
-
-    if (millis() > (now + period)) { 
+    // Send a new inventory command once the previous one is answered
+    if (!TictagUhf.isBusy() && (millis() - now >= period)) { 
         now = millis();
-        TictagUhf.getRawData(reData, cmd, sizeCmd); //< Get raw data from 
-                                                    //  inventory command
+        TictagUhf.sendRequest_P(Inventory::frame, Inventory::SIZE);
+    }
+
+    // receive() never blocks, it returns STATUS_RS485_BUSY until the whole
+    // response frame has arrived.
+    status = TictagUhf.receive();
+    if (status == ERR_RS485_TIMEOUT) {
+        Serial.println("[ERROR 0x1B] No response from UHF reader.");
+    } else if (status == STATUS_SUCCESS) {
+        byte* reData = TictagUhf.getFrame(); //< Get raw data from 
+                                             //  inventory command
+        size_t sizeData = TictagUhf.getFrameSize();
         if (reData[RE_STATUS_INDEX] == ERR_INV_NO_CARD) {
             Serial.println("[ERROR 0xFB] No cards in the effective field.");
         } else if (reData[RE_STATUS_INDEX] == ERR_CRC) {
@@ -78,10 +87,10 @@ void loop()
             Serial.println("[ERROR N/A] Refer to doc/Protocols for more info.");
         }
 
-        TictagUhf._debugPrintRawData(reData, sizeof(reData)); //< Print default (HEX)
+        TictagUhf._debugPrintRawData(reData, sizeData); //< Print default (HEX)
 
         // Print with specified base
-        // TictagUhf._debugPrintRawData(reData, sizeof(reData), DEC); 
+        // TictagUhf._debugPrintRawData(reData, sizeData, DEC); 
         Serial.println();
     }
 }
@@ -0,0 +1,68 @@
+#include "BusScheduler.h"
+#include "Database.h"
+#include "InventorySession.h"
+#include "UHFRecv.h"
+
+#define RS485_CONTROL           4  //< Pin for RS485 Direction Control
+#define BAUD_RATE               57600
+#define NUM_READERS             2  //< Readers at addresses 0x00 and 0x01
+
+UHFRecv TictagUhf(Serial1, BAUD_RATE, RS485_CONTROL); //< Shared by every reader
+Database* databases[NUM_READERS]; //< One database per reader
+InventorySession* sessions[NUM_READERS];
+BusScheduler bus(TictagUhf);
+byte readers[NUM_READERS]; //< Address of each reader, context of its events
+
+/* Called by the database of a reader when a card arrives */
+void onCard(const CardEvent& event, void* context)
+{
+    if (event.type != CARD_ARRIVED)
+        return;
+
+    char line[DEBUG_LINE_SIZE];
+    TextBuffer text(line, sizeof(line));
+    text.print("Reader ");
+    text.print(*(byte*)context);
+    text.print(": hello ");
+    printTid(text, event.key);
+    text.println(". ");
+    Serial.write(text.c_str(), text.length()); //< One write per line
+}
+
+/* Called every time the inventory session of a reader is finished */
+void onSession(byte reader, Status status, void* context)
+{
+    if (status != STATUS_SUCCESS && status != ERR_INV_NO_CARD) {
+        Serial.print("Reader ");
+        Serial.print(reader);
+        Serial.print(": error 0x");
+        Serial.println(status, HEX);
+    }
+    // New cards are welcomed by onCard(), while the frames are stored
+}
+
+void setup()
+{
+    Serial.begin(9600);
+    TictagUhf.begin();
+
+    for (byte i = 0; i < NUM_READERS; i++) {
+        databases[i] = new Database;
+        databases[i]->begin();
+        readers[i] = i;
+        databases[i]->setEventCallback(onCard, &readers[i]);
+        sessions[i] = new InventorySession(TictagUhf, *databases[i]);
+        bus.addReader(*sessions[i], i, DEFAULT_RX_TIMEOUT);
+    }
+    bus.setCallback(onSession, NULL);
+    bus.setPeriod(0); //< Sweep the readers back to back
+
+    Serial.println("Scanning cards...");
+}
+
+void loop()
+{
+    // Never blocks: the next reader is inventoried as soon as the previous
+    // one has answered (or timed out)
+    bus.poll();
+}
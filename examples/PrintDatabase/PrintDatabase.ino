@@ -1,4 +1,5 @@
 #include "Database.h"
+#include "InventorySession.h"
 #include "UHFRecv.h"
 
 #define RS485_CONTROL           4  //< Pin for RS485 Direction Control
@@ -14,12 +15,16 @@ void flash();
 * be crashed. I still dont know the reasons yet. But better using pointer.
 */
 Database* database; 
+InventorySession* session; //< Collects every frame of an inventory command
 
 UHFRecv TictagUhf(Serial1, BAUD_RATE, RS485_CONTROL);
 
 // UHFRecv can also be instantiated like this
 // UHFRecv TictagUhf(Serial1, BAUD_RATE, SERIAL_8N1, RS485_CONTROL);
 
+// Inventory command, built at compile time and stored in flash (see `Command.h`)
+typedef InventoryCommand<READER_ADDRESS, TID_ARRESSS, LENGTH_TID> Inventory;
+
 uint32_t now = 0;
 uint32_t period = 600; //< Change this value to modify time between inventory
                        //  sessions (600 means 600 ms).
@@ -40,6 +45,7 @@ void setup()
     flash();
     database = new Database;
     database->begin();
+    session = new InventorySession(TictagUhf, *database);
 
     /* Setting prefix */
     String prefix = "";
@@ -58,31 +64,32 @@ void loop()
 {
     Status status = 0x00;
 
-    byte reData[INV_MAX_SIZE] = {0};
-    
-    byte* cmd = TictagUhf.setCommand(READER_ADDRESS, TID_ARRESSS, LENGTH_TID);
-    size_t sizeCmd = TictagUhf.getSizeCommand();
-
-    if (millis() > (now + period)) { 
+    // Send a new inventory command once the previous session is finished
+    if (!session->isBusy() && (millis() - now >= period)) { 
         now = millis();
-        TictagUhf.getRawData(reData, cmd, sizeCmd); //< Get raw data from 
-                                                    //  inventory command
-        if (TictagUhf.isDataPreserved(reData, sizeof(reData))) {
-            if ((status = database->updateDB(reData)) != STATUS_SUCCESS) {
-                Serial.print("[ERROR ");
-                Serial.print(status, HEX);
-                if (status == 0xFB) {
-                    Serial.println("] No cards in the effective field.");
-                } 
-                // Add more potential errors here 
-                return ;
-            }
-            if (Serial1.available() > 0) 
-                database->_debugPrintDB(database->getDB());
+        session->start_P(Inventory::frame, Inventory::SIZE);
+    }
+
+    // poll() never blocks, it returns STATUS_RS485_BUSY until every frame of
+    // the inventory session has arrived.
+    status = session->poll();
+    if ((status == STATUS_RS485_BUSY) || (status == ERR_READ_RS485))
+        return ;
+
+    if (status == ERR_CRC) {
+        Serial.println("Error: Data are not preserved.");
+    } else if (status != STATUS_SUCCESS) {
+        Serial.print("[ERROR ");
+        Serial.print(status, HEX);
+        if (status == 0xFB) {
+            Serial.println("] No cards in the effective field.");
         } else {
-            Serial.println("Error: Data are not preserved.");
+            Serial.println("]");
         }
+        // Add more potential errors here 
+        return ;
     }
+    database->_debugPrintDB(database->getDB());
 }
 
 void flash()
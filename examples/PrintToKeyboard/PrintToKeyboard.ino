@@ -1,4 +1,9 @@
 #include "Database.h"
+#include "DatabaseJournal.h"
+#include "EepromStorage.h"
+#include "Instrument.h"
+#include "InventorySession.h"
+#include "PollController.h"
 #include "UHFRecv.h"
 
 #define RS485_CONTROL           4  //< Pin for RS485 Direction Control
@@ -11,11 +16,20 @@
 void flash();
 
 Database* database;
+InventorySession* session; //< Collects every frame of an inventory command
 UHFRecv TictagUhf(Serial1, BAUD_RATE, RS485_CONTROL);
 
-uint32_t now = 0;
-uint32_t period = 600; //< Change this value to modify time between inventory
-                       //  sessions (600 means 600 ms).
+// Inventory command, built at compile time and stored in flash (see `Command.h`)
+typedef InventoryCommand<READER_ADDRESS, TID_ARRESSS, LENGTH_TID> Inventory;
+
+PollController rate; //< Time between inventory sessions, adapted to the 
+                     //  cards in the field
+uint32_t arrivals = 0; //< Database::getNumArrivals() at the session start
+
+// Typed cards are kept in the EEPROM, so they are not typed again after a
+// reset (see `DatabaseJournal.h`)
+EepromStorage storage(0, EEPROM.length());
+DatabaseJournal journal(storage);
 
 void setup()
 {
@@ -37,6 +51,25 @@ void setup()
     #endif
     database = new Database;
     database->begin();
+    database->restore(journal);
+
+    // Keyboard pacing: bursts of up to 8 cards, each one followed by Enter,
+    // 100 ms between bursts, no pause between keystrokes, up to 8 keystrokes
+    // per loop(). 15 cards are typed in less than a second (a USB keystroke
+    // takes about 2 ms). Use setBurst(1, '\n') and setPacing(800, 0, 4) for
+    // hosts which drop keystrokes, getKeysPerSecond() tells the rate achieved.
+    database->getKeyboard().setBurst(8, '\n');
+    database->getKeyboard().setPacing(100, 0, 8);
+
+    // Uncomment to type tokens of 14 keystrokes instead of 24 (base 32 and
+    // a check character, see `TokenEncoding`), the web app must decode them
+    // database->setEncoding(TOKEN_BASE32, true);
+
+    // Poll every 50 ms while cards arrive, back off to 1 s when the field
+    // stays empty (after 4 empty sessions, +50% per empty session)
+    rate.setLimits(50, 1000);
+    rate.setAggressiveness(4, 1);
+    session = new InventorySession(TictagUhf, *database);
 
     /* Setting prefix */
     String prefix = "";
@@ -57,23 +90,37 @@ void loop()
 {
     Status status = 0x00;
 
-    byte reData[INV_MAX_SIZE] = {0};
-    
-    byte* cmd = TictagUhf.setCommand(READER_ADDRESS, TID_ARRESSS, LENGTH_TID);
-    size_t sizeCmd = TictagUhf.getSizeCommand();
-
-    if (millis() > (now + period)) { 
-        now = millis();
-        TictagUhf.getRawData(reData, cmd, sizeCmd); //< Get raw data from 
-                                                    //  inventory command
-        if (TictagUhf.isDataPreserved(reData, sizeof(reData))) {
-            if ((status = database->updateDB(reData)) != STATUS_SUCCESS)
-                return ;
-            database->printToKeyboard();
-        } else {
-            Keyboard.println("CSERR");
-        }
+    // Type queued TIDs a few keystrokes at a time (never blocks)
+    database->getKeyboard().run();
+
+    // Write the typed cards to the EEPROM, a few bytes per loop()
+    database->sync(millis());
+
+    // Send '?' over Serial to print the time spent in each stage of a poll
+    // (only if `UHF_INSTRUMENT` is defined, see `Instrument.h`)
+    instrumentPoll(Serial);
+
+    // Send a new inventory command once the previous session is finished
+    if (!session->isBusy() && rate.isDue()) { 
+        arrivals = database->getNumArrivals();
+        session->start_P(Inventory::frame, Inventory::SIZE);
+    }
+
+    // poll() never blocks, it returns STATUS_RS485_BUSY until every frame of
+    // the inventory session has arrived.
+    status = session->poll();
+    if ((status == STATUS_RS485_BUSY) || (status == ERR_READ_RS485))
+        return ;
+
+    rate.update((status == STATUS_SUCCESS) ? session->getFrameStatus() : status,
+                database->getNumArrivals() - arrivals);
+
+    if (status == ERR_CRC) {
+        database->getKeyboard().enqueue("CSERR");
+    } else if (status != STATUS_SUCCESS) {
+        return ;
     }
+    database->printToKeyboard();
 }
 
 void flash()
@@ -0,0 +1,85 @@
+/*
+* @brief Host benchmark of the CRC-16 engines (see `Crc16.h`)
+*
+* @detail
+* Every engine is run over a full inventory response frame (15 cards, 112
+* bytes) and the cost is reported in cycles per byte (nanoseconds per byte
+* on non-x86 hosts). All engines are checked against the bitwise one first.
+*
+* Built by the host CMake build (`crc16_bench`) and run by its `bench`
+* target, after `uhf_bench` (which times the engines in JSON Lines).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "Crc16.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define BENCH_UNIT "cycles/byte"
+    static inline uint64_t benchClock() { return __rdtsc(); }
+#else
+    #define BENCH_UNIT "ns/byte"
+    static inline uint64_t benchClock()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+#endif
+
+typedef uint16_t (*CrcEngine)(uint16_t, const uint8_t*, size_t);
+
+struct Engine {
+    const char* name;
+    CrcEngine func;
+};
+
+static const Engine ENGINES[] = {
+    { "bitwise", crc16Bitwise },
+    { "nibble",  crc16Nibble },
+    { "table",   crc16Table },
+    { "slice4",  crc16Slice4 }
+};
+
+static const size_t FRAME_SIZE = 112; //< 15 cards * (6 + 1) bytes + 7 bytes
+static const size_t ROUNDS     = 200000;
+
+int main()
+{
+    uint8_t frame[FRAME_SIZE];
+    srand(1);
+    for (size_t i = 0; i < FRAME_SIZE; i++)
+        frame[i] = (uint8_t)rand();
+
+    // Every engine must agree with the bitwise one for every frame length
+    for (size_t len = 0; len <= FRAME_SIZE; len++) {
+        uint16_t expected = crc16Bitwise(CRC16_INIT, frame, len);
+        for (size_t e = 1; e < sizeof(ENGINES) / sizeof(ENGINES[0]); e++) {
+            if (ENGINES[e].func(CRC16_INIT, frame, len) != expected) {
+                printf("[ERROR] %s differs at length %zu\n",
+                       ENGINES[e].name, len);
+                return 1;
+            }
+        }
+    }
+
+    double base = 0;
+    printf("%-8s %12s %8s\n", "engine", BENCH_UNIT, "speedup");
+    for (size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); e++) {
+        volatile uint16_t sink = 0;
+        uint64_t start = benchClock();
+        for (size_t r = 0; r < ROUNDS; r++) {
+            frame[0] = (uint8_t)r; //< defeat hoisting out of the loop
+            sink = ENGINES[e].func(CRC16_INIT, frame, FRAME_SIZE);
+        }
+        uint64_t elapsed = benchClock() - start;
+        (void)sink;
+
+        double perByte = (double)elapsed / ((double)ROUNDS * FRAME_SIZE);
+        if (e == 0)
+            base = perByte;
+        printf("%-8s %12.2f %7.1fx\n", ENGINES[e].name, perByte, base / perByte);
+    }
+    return 0;
+}
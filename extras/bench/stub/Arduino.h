@@ -0,0 +1,17 @@
+/*
+* Minimal stand-in of `Arduino.h` for the host benchmarks in `extras/bench`.
+* It only provides what `attribute.h` and the header-only containers need.
+*/
+#ifndef _BENCH_STUB_ARDUINO_H_
+#define _BENCH_STUB_ARDUINO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define HIGH                         0x1
+#define LOW                          0x0
+
+#endif
@@ -0,0 +1,135 @@
+/*
+* @brief Host benchmark of the TID lookup of `Database::updateDB()`
+*
+* @detail
+* One poll (15 inventoried cards, half of them already in the database) is
+* matched against databases of different sizes with:
+* - string: the previous lookup, every TID of the database is formatted to a
+*   decimal string and compared (`std::string` stands in for `String`).
+* - slice: packed TIDs of the whole database scanned by findTid(), a
+*   branch-free linear scan (the baseline of the index).
+* - index: `TidIndex`, the hash index used by `Database::updateDB()`.
+*
+* Built by the host CMake build (`tid_index_bench`) and run by its `bench`
+* target, after `uhf_bench` (which times `updateDB()` in JSON Lines).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "attribute.h"
+#include "TidIndex.h"
+
+static const size_t CARDS_PER_POLL = MAX_CARDS;
+
+static std::string tidToString(const TID& tid)
+{
+    std::string strTid;
+    char digits[4];
+    for (size_t i = 0; i < tid.size; i++) {
+        snprintf(digits, sizeof(digits), "%03u", tid.tidByte[i]);
+        strTid += digits;
+    }
+    return strTid;
+}
+
+static TID randomTid()
+{
+    TID tid;
+    tid.size = MAX_SIZE_TID;
+    for (size_t i = 0; i < MAX_SIZE_TID; i++)
+        tid.tidByte[i] = (byte)rand();
+    return tid;
+}
+
+/*
+* Index of the first element of `keys` equal to `key`, `count` if not found.
+* The loop has no early exit and no branch, so compilers can vectorise it
+* (e.g. SSE/AVX/NEON at `-O3`).
+*/
+static size_t findTid(const TidKey* keys, size_t count, const TidKey key)
+{
+    size_t found = count;
+    for (size_t i = count; i > 0; i--) {
+        found = (keys[i - 1] == key) ? (i - 1) : found;
+    }
+    return found;
+}
+
+/* Cost of one poll (ns) against a database of `size` cards */
+template <size_t TableSize, typename Slot>
+static void benchPoll(size_t size)
+{
+    std::vector<Card> cards(size);
+    TidIndex<TableSize, Slot> index(cards.data());
+    for (size_t i = 0; i < size; i++) {
+        cards[i].tid = randomTid();
+        index.insert((Slot)i);
+    }
+
+    std::vector<TidKey> keys(size);
+    for (size_t i = 0; i < size; i++)
+        keys[i] = packTid(cards[i].tid);
+
+    // Half of the cards of a poll are in the database, half of them are not
+    TID poll[CARDS_PER_POLL];
+    TidKey pollKeys[CARDS_PER_POLL];
+    for (size_t i = 0; i < CARDS_PER_POLL; i++) {
+        poll[i] = (i % 2) ? cards[rand() % size].tid : randomTid();
+        pollKeys[i] = packTid(poll[i]);
+    }
+
+    const size_t rounds = 2000000 / size + 10;
+    volatile size_t hits = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < CARDS_PER_POLL; i++) {
+            std::string newTid = tidToString(poll[i]);
+            for (size_t j = 0; j < size; j++) {
+                if (tidToString(cards[j].tid) == newTid) {
+                    hits = hits + 1;
+                    break;
+                }
+            }
+        }
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds * 10; r++) {
+        for (size_t i = 0; i < CARDS_PER_POLL; i++) {
+            if (findTid(keys.data(), size, pollKeys[i]) != size)
+                hits = hits + 1;
+        }
+    }
+    auto mid2 = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds * 100; r++) {
+        for (size_t i = 0; i < CARDS_PER_POLL; i++) {
+            if (index.find(pollKeys[i]) != index.NONE)
+                hits = hits + 1;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double stringNs = std::chrono::duration<double, std::nano>(mid - start).count()
+                      / rounds;
+    double sliceNs = std::chrono::duration<double, std::nano>(mid2 - mid).count()
+                     / (rounds * 10);
+    double indexNs = std::chrono::duration<double, std::nano>(end - mid2).count()
+                     / (rounds * 100);
+    printf("%8zu %16.0f %16.0f %16.0f\n", size, stringNs, sliceNs, indexNs);
+}
+
+int main()
+{
+    srand(1);
+    printf("%8s %16s %16s %16s\n", "cards", "string ns/poll", "slice ns/poll",
+           "index ns/poll");
+    benchPoll<64, byte>(25);
+    benchPoll<256, byte>(100);
+    benchPoll<512, byte>(250);
+    benchPoll<2048, uint16_t>(1000);
+    benchPoll<8192, uint16_t>(4000);
+    return 0;
+}
@@ -0,0 +1,1553 @@
+/*
+* @brief Host micro-benchmark suite of the hot paths of one poll
+*
+* @detail
+* Cases (each one is a line of JSON, see below):
+* - crc16: every CRC-16 engine (see `Crc16.h`) over 7, 112 and 1024 bytes.
+* - setCommand: inventory command with the same parameters as the last one
+*   (kept) and with new ones. Its check compares `InventoryCommand` (built at
+*   compile time, see `Command.h`) with setCommand().
+* - isDataPreserved: checksum test of an inventory frame of 1, 5, 15 cards.
+*   Its check also covers frames in a larger buffer (size from the Len byte)
+*   and the CRC-16 updated by receive() as bytes arrive (over a pipe).
+* - spscRing: hand-off of one element between 2 threads through a
+*   `SpscRing` of 64 elements (1-byte indices). Its check counts on the
+*   consumer that every element arrives once and in order, across many
+*   wrap-arounds of the indices, and covers a full and an empty ring.
+* - inventoryFrame: in-place view (`InventoryFrame.h`) of an inventory frame
+*   of 1, 5, 15 cards. Its check compares the TIDs with the byte-by-byte
+*   parse, and covers frames whose TIDs run past the CRC.
+* - updateDB: merge of 1, 5, 15 cards into a database filled at 50% and
+*   "full but room for the poll", with 0%, 50% and 100% of hits (cards which
+*   are already in the database).
+* - repeats: merge of a frame of 15 TIDs, of which 15, 5 or 1 are distinct,
+*   into a database which knows them. Its check covers TIDs repeated in the
+*   frames of a multi-frame session (see `SessionFilter.h`).
+* - toString, generateHash: encoding of a 6-byte TID.
+* - printTid, printHash: the same encodings into a `TextBuffer` (no String).
+*   The check of printHash also counts the heap allocations of a poll
+*   (updateDB() + printToKeyboard() + keyboard run()): there must be none.
+* - printToken: token of a card of the database, from the random bytes drawn
+*   when it arrived. Its check decodes the tokens and prints them again.
+* - token: printHash() in every `TokenEncoding`, with a check character
+*   (`chars` is the number of keystrokes of a token).
+* - pollController: check only, a scripted sequence of session outcomes and
+*   the period chosen after each one (`PollController.h`).
+* - keyboard: a whole arrival (updateDB() of `MAX_CARDS` new cards, then
+*   printToKeyboard() and keyboard run() until every token is typed), in
+*   bursts of 8 tokens. The host keyboard does not wait for USB, so the time
+*   is the pacing. Its check covers the bursts, the separator and the pause
+*   of `KeyboardScheduler`.
+* - events: the events of `Database::setEventCallback()`. Its check also
+*   covers more arrivals than the database holds before printToKeyboard().
+* - printToKeyboard: call with no new card, the database is full of typed
+*   cards. Only new cards are visited, so it does not depend on the capacity.
+* - restore: warm restart of a database whose capacity is filled with typed
+*   cards (`Database::restore()`). Its check replays visitors (arrive, typed,
+*   leave) with a power loss after every few bytes written to the storage:
+*   the cards restored must be the typed cards at some point of the visits
+*   (never a mix), and every change must be restored without power loss, in
+*   RAM, EEPROM and memory-mapped file storage.
+*
+* Differential checks: the optimised paths are compared with reference
+* implementations (the code as it was before it was optimised: bitwise
+* CRC, byte-by-byte parse, linear database, String-based encoding). A
+* mismatch is reported as a `check` line with `"pass": false` and the exit
+* code is 1.
+*
+* The capacity of the database is a compile-time constant: CMake builds one
+* `uhf_bench_<capacity>` per entry of `UHF_BENCH_CAPACITIES` and the `bench`
+* target runs them all into `bench.jsonl`.
+*
+* Output (JSON Lines), e.g.
+* ```
+* {"commit":"abc1234","capacity":25,"case":"updateDB","cards":15,"fill":10,"hit":0.50,"ns":812.4}
+* {"commit":"abc1234","capacity":25,"case":"check","name":"updateDB","pass":true}
+* ```
+* `ns` is the median time of one operation over several batches.
+*
+* Usage: uhf_bench_<capacity> [-l label] [-r rounds] [-o file]
+* - label: e.g. commit of the run (default: commit at configure time).
+* - rounds: operations per batch (default: 20000).
+* - file: append the results to a file (default: standard output).
+*/
+#include <Arduino.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Command.h"
+#include "Crc16.h"
+#include "Database.h"
+#include "DatabaseJournal.h"
+#include "EepromStorage.h"
+#include "InventoryFrame.h"
+#include "MappedFileStorage.h"
+#include "PollController.h"
+#include "SpscRing.h"
+#include "TextBuffer.h"
+#include "TidKey.h"
+#include "UHFRecv.h"
+
+#ifndef UHF_BENCH_COMMIT
+#define UHF_BENCH_COMMIT "unknown"
+#endif
+
+static const char* label = UHF_BENCH_COMMIT;
+static size_t rounds = 20000; //< Operations per batch (scaled down for slow cases)
+static const size_t BATCHES = 7;
+static bool isPassed = true;
+static FILE* out = stdout;
+static size_t numAllocations = 0; //< Calls of operator new
+
+void* operator new(size_t size)
+{
+    numAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t size) noexcept
+{
+    (void)size;
+    free(p);
+}
+
+/*
+* Reference implementations
+*/
+
+/* CRC-16 of `UHFRecv::_calculateCrc()`, before the CRC engines */
+static uint16_t refCrc(const byte* data, size_t size)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (byte j = 0; j < 8; j++) {
+            if (crc & 0x0001)
+                crc = (crc >> 1) ^ 0x8408;
+            else
+                crc = crc >> 1;
+        }
+    }
+    return crc;
+}
+
+/* CRC bytes (LSB, MSB) of the frame match its content */
+static bool refIsDataPreserved(const byte* frame, size_t size)
+{
+    if (frame[RE_STATUS_INDEX] == ERR_CRC)
+        return false;
+    uint16_t crc = refCrc(frame, size - 2);
+    return (frame[size - 2] == lowByte(crc)) && (frame[size - 1] == highByte(crc));
+}
+
+/* Cards of an inventory frame */
+static std::vector<TID> refParse(const byte* frame)
+{
+    std::vector<TID> tids;
+    size_t index = RE_INV_TID_SIZE_INDEX;
+    for (byte i = 0; i < frame[RE_INV_NUM_CARDS_INDEX]; i++) {
+        TID tid = {0};
+        tid.size = frame[index];
+        memcpy(tid.tidByte, frame + index + 1, tid.size);
+        tids.push_back(tid);
+        index += tid.size + 1;
+    }
+    return tids;
+}
+
+static std::string refToString(const TID& tid)
+{
+    std::string str;
+    char digits[4];
+    for (size_t i = 0; i < tid.size; i++) {
+        snprintf(digits, sizeof(digits), "%03u", tid.tidByte[i]);
+        str += digits;
+    }
+    return str;
+}
+
+/* Same random numbers as `generateHash()` (2 keys of random(1, 255)) */
+static std::string refGenerateHash(TID tid, const std::string& prefix)
+{
+    byte key[2];
+    for (byte i = 0; i < 2; i++)
+        key[i] = random(1, 255);
+    for (byte i = 0; i < tid.size; i++)
+        tid.tidByte[i] ^= key[i % 2];
+
+    std::string str = prefix + refToString(tid);
+    char digits[4];
+    for (byte i = 0; i < 2; i++) {
+        snprintf(digits, sizeof(digits), "%03u", key[i]);
+        str += digits;
+    }
+    return str;
+}
+
+/* Bytes of a hash: same random numbers as `generateHash()` */
+static std::vector<byte> refHashBytes(const TID& tid)
+{
+    byte key[2];
+    for (byte i = 0; i < 2; i++)
+        key[i] = random(1, 255);
+
+    std::vector<byte> data;
+    for (byte i = 0; i < tid.size; i++)
+        data.push_back(tid.tidByte[i] ^ key[i % 2]);
+    data.push_back(key[0]);
+    data.push_back(key[1]);
+    return data;
+}
+
+/* Token of the bytes of a hash (see `TokenEncoding`), bit by bit */
+static std::string refToken(const std::vector<byte>& data, TokenEncoding encoding, bool hasCheck)
+{
+    static const char* symbols = "0123456789ABCDEFGHJKMNPQRSTVWXYZ*~$=U";
+    std::string str;
+    char digits[4];
+    if (encoding == TOKEN_DECIMAL) {
+        for (size_t i = 0; i < data.size(); i++) {
+            snprintf(digits, sizeof(digits), "%03u", data[i]);
+            str += digits;
+        }
+    } else if (encoding == TOKEN_HEX) {
+        for (size_t i = 0; i < data.size(); i++) {
+            snprintf(digits, sizeof(digits), "%02X", data[i]);
+            str += digits;
+        }
+    } else {
+        size_t numBits = 8 * data.size();
+        for (size_t bit = 0; bit < numBits; bit += 5) {
+            byte value = 0;
+            for (size_t j = bit; j < bit + 5; j++) {
+                bool isSet = (j < numBits) && ((data[j / 8] >> (7 - j % 8)) & 1);
+                value = (value << 1) | isSet;
+            }
+            str += symbols[value];
+        }
+    }
+
+    if (hasCheck) {
+        unsigned __int128 value = 0;
+        for (size_t i = 0; i < data.size(); i++)
+            value = (value << 8) | data[i];
+        str += symbols[(size_t)(value % 37)];
+    }
+    return str;
+}
+
+/* Live cards of the database: TID -> status (a linear model) */
+typedef std::vector<std::pair<std::string, bool> > RefDatabase;
+
+static void refUpdate(RefDatabase& database, const std::vector<TID>& tids)
+{
+    for (size_t i = 0; i < tids.size(); i++) {
+        std::string key = refToString(tids[i]);
+        bool isFound = false;
+        for (size_t j = 0; j < database.size(); j++) {
+            if (database[j].first == key) {
+                isFound = true;
+                break;
+            }
+        }
+        if (!isFound && database.size() < DATABASE_CAPACITY)
+            database.push_back(std::make_pair(key, false));
+    }
+}
+
+/*
+* Helpers
+*/
+
+static uint32_t _seed = 1;
+
+static byte nextByte()
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return (byte)(_seed >> 24);
+}
+
+static TID randomTid()
+{
+    TID tid;
+    tid.size = MAX_SIZE_TID;
+    for (size_t i = 0; i < MAX_SIZE_TID; i++)
+        tid.tidByte[i] = nextByte();
+    return tid;
+}
+
+/* Inventory frame of `tids`, with a valid CRC */
+static std::vector<byte> makeFrame(const std::vector<TID>& tids, const byte status)
+{
+    std::vector<byte> frame(RE_INV_TID_SIZE_INDEX);
+    frame[RE_ADDRESS_INDEX] = READER_ADDRESS;
+    frame[RE_COMMAND_INDEX] = 0x01;
+    frame[RE_STATUS_INDEX] = status;
+    frame[RE_INV_NUM_CARDS_INDEX] = tids.size();
+    for (size_t i = 0; i < tids.size(); i++) {
+        frame.push_back(tids[i].size);
+        frame.insert(frame.end(), tids[i].tidByte, tids[i].tidByte + tids[i].size);
+    }
+    frame[RE_LENGTH_INDEX] = frame.size() + 1;
+
+    uint16_t crc = refCrc(frame.data(), frame.size());
+    frame.push_back(lowByte(crc));
+    frame.push_back(highByte(crc));
+    return frame;
+}
+
+static std::vector<TID> randomTids(size_t count)
+{
+    std::vector<TID> tids;
+    for (size_t i = 0; i < count; i++)
+        tids.push_back(randomTid());
+    return tids;
+}
+
+static std::vector<TID> sliceTids(const std::vector<TID>& tids, size_t first, size_t count)
+{
+    return std::vector<TID>(tids.begin() + first, tids.begin() + first + count);
+}
+
+static double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Median of the batches */
+static double median(std::vector<double>& ns)
+{
+    std::sort(ns.begin(), ns.end());
+    return ns[ns.size() / 2];
+}
+
+static void printResult(const char* name, const char* params, double ns)
+{
+    fprintf(out, "{\"commit\":\"%s\",\"capacity\":%d,\"case\":\"%s\",%s,\"ns\":%.1f}\n",
+           label, DATABASE_CAPACITY, name, params, ns);
+}
+
+static void printCheck(const char* name, bool isPass)
+{
+    fprintf(out, "{\"commit\":\"%s\",\"capacity\":%d,\"case\":\"check\",\"name\":\"%s\",\"pass\":%s}\n",
+           label, DATABASE_CAPACITY, name, isPass ? "true" : "false");
+    if (!isPass)
+        isPassed = false;
+}
+
+/* Median time (ns) of `op()` */
+template <typename Op>
+static double measure(Op op, size_t count)
+{
+    std::vector<double> ns;
+    for (size_t b = 0; b < BATCHES; b++) {
+        double start = nowNs();
+        for (size_t i = 0; i < count; i++)
+            op(i);
+        ns.push_back((nowNs() - start) / count);
+    }
+    return median(ns);
+}
+
+static volatile uint32_t sink;
+
+/*
+* Cases
+*/
+
+typedef uint16_t (*CrcEngine)(uint16_t, const uint8_t*, size_t);
+
+static void benchCrc()
+{
+    const struct { const char* name; CrcEngine func; } engines[] = {
+        { "bitwise", crc16Bitwise },
+        { "nibble",  crc16Nibble },
+        { "table",   crc16Table },
+        { "slice4",  crc16Slice4 }
+    };
+    const size_t sizes[] = { 7, 112, 1024 };
+
+    std::vector<byte> data(1024);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = nextByte();
+
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        bool isPass = true;
+        for (size_t len = 0; len <= data.size(); len++) {
+            if (engines[e].func(CRC16_INIT, data.data(), len) != refCrc(data.data(), len))
+                isPass = false;
+        }
+        std::string name = std::string("crc16.") + engines[e].name;
+        printCheck(name.c_str(), isPass);
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            size_t size = sizes[s];
+            double ns = measure([&](size_t i) {
+                data[0] = (byte)i; //< defeat hoisting out of the loop
+                sink = engines[e].func(CRC16_INIT, data.data(), size);
+            }, rounds);
+
+            char params[64];
+            snprintf(params, sizeof(params), "\"engine\":\"%s\",\"bytes\":%zu",
+                     engines[e].name, size);
+            printResult("crc16", params, ns);
+        }
+    }
+}
+
+/* Frame of `Command` matches setCommand() */
+template <typename Command>
+static bool isSameCommand(UHFRecv& uhf, byte address, byte tidAddress, byte tidLength)
+{
+    static_assert(Command::SIZE == 7, "Inventory command is 7 bytes");
+    byte* cmd = uhf.setCommand(address, tidAddress, tidLength);
+    return (uhf.getSizeCommand() == Command::SIZE)
+           && (memcmp(cmd, Command::frame, Command::SIZE) == 0)
+           && (refCrc(cmd, Command::SIZE) == 0);
+}
+
+static void benchCommand(UHFRecv& uhf)
+{
+    bool isPass = true;
+    isPass &= isSameCommand<InventoryCommand<READER_ADDRESS, TID_ARRESSS, LENGTH_TID> >(
+        uhf, READER_ADDRESS, TID_ARRESSS, LENGTH_TID);
+    isPass &= isSameCommand<InventoryCommand<0x05, 0x00, 0x0F> >(uhf, 0x05, 0x00, 0x0F);
+    isPass &= isSameCommand<InventoryCommand<0xFF, 0x7A, 0x01> >(uhf, 0xFF, 0x7A, 0x01);
+    printCheck("command", isPass);
+
+    // setCommand() with the same parameters (kept) and with new ones
+    double ns = measure([&](size_t i) {
+        sink = uhf.setCommand(READER_ADDRESS, TID_ARRESSS, LENGTH_TID)[5];
+    }, rounds);
+    printResult("setCommand", "\"cached\":true", ns);
+
+    ns = measure([&](size_t i) {
+        sink = uhf.setCommand((byte)i, TID_ARRESSS, LENGTH_TID)[5];
+    }, rounds);
+    printResult("setCommand", "\"cached\":false", ns);
+}
+
+static void benchIsDataPreserved(UHFRecv& uhf)
+{
+    const size_t counts[] = { 1, 5, MAX_CARDS };
+
+    bool isPass = true;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        std::vector<byte> frame = makeFrame(randomTids(counts[c]), STATUS_SUCCESS);
+
+        // Valid frame, then every single bit flip
+        isPass &= (uhf.isDataPreserved(frame.data(), frame.size())
+                   == refIsDataPreserved(frame.data(), frame.size()));
+        for (size_t bit = 0; bit < frame.size() * 8; bit++) {
+            frame[bit / 8] ^= 1 << (bit % 8);
+            if (frame[RE_LENGTH_INDEX] + 1 == (int)frame.size())
+                isPass &= (uhf.isDataPreserved(frame.data(), frame.size())
+                           == refIsDataPreserved(frame.data(), frame.size()));
+            frame[bit / 8] ^= 1 << (bit % 8);
+        }
+
+        // Frame in a buffer of `INV_MAX_SIZE` bytes
+        std::vector<byte> buffer(frame);
+        buffer.resize(INV_MAX_SIZE, 0xAA);
+        isPass &= uhf.isDataPreserved(buffer.data(), buffer.size());
+
+        double ns = measure([&](size_t i) {
+            sink = uhf.isDataPreserved(frame.data(), frame.size());
+        }, rounds);
+
+        char params[64];
+        snprintf(params, sizeof(params), "\"cards\":%zu,\"bytes\":%zu",
+                 counts[c], frame.size());
+        printResult("isDataPreserved", params, ns);
+    }
+    printCheck("isDataPreserved", isPass);
+}
+
+/* Receive `bytes` with `uhf` (over `fd`), return isDataPreserved() */
+static bool receiveAndCheck(UHFRecv& uhf, int fd, const std::vector<byte>& bytes)
+{
+    byte* cmd = uhf.setCommand(READER_ADDRESS, TID_ARRESSS, LENGTH_TID);
+    uhf.sendRequest(cmd, uhf.getSizeCommand());
+    if (write(fd, bytes.data(), bytes.size()) != (ssize_t)bytes.size())
+        return false;
+
+    Status status;
+    while ((status = uhf.receive()) == STATUS_RS485_BUSY) {}
+    return (status == STATUS_SUCCESS) && uhf.isDataPreserved();
+}
+
+static void checkStreamingCrc()
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        printCheck("isDataPreserved.stream", false);
+        return;
+    }
+    HardwareSerial serial(fds[0]);
+    UHFRecv uhf(serial, 1000000, DEFAULT_RS485_CTL_PIN);
+    const size_t counts[] = { 0, 1, 5, MAX_CARDS };
+
+    bool isPass = true;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        std::vector<byte> frame = makeFrame(randomTids(counts[c]), STATUS_SUCCESS);
+        isPass &= receiveAndCheck(uhf, fds[1], frame);
+
+        // Garbage bytes before the frame are dropped (CRC calculated again)
+        std::vector<byte> noisy(frame);
+        noisy.insert(noisy.begin(), 0x02);
+        isPass &= receiveAndCheck(uhf, fds[1], noisy);
+
+        // Every single bit flip after the header (a bad header is dropped by
+        // the receiver, the frame is never complete)
+        for (size_t bit = RE_STATUS_INDEX * 8; bit < frame.size() * 8; bit++) {
+            std::vector<byte> flipped(frame);
+            flipped[bit / 8] ^= 1 << (bit % 8);
+            isPass &= (receiveAndCheck(uhf, fds[1], flipped)
+                       == refIsDataPreserved(flipped.data(), flipped.size()));
+        }
+    }
+    close(fds[1]);
+    printCheck("isDataPreserved.stream", isPass);
+}
+
+static void benchSpscRing()
+{
+    // One context: full and empty ring, indices wrap around
+    SpscRing<uint32_t, 64> ring;
+    uint32_t value = 0;
+    bool isPass = ring.isEmpty() && (ring.dequeue(value) == ERR_QUEUE_EMPTY);
+    for (uint32_t round = 0; round < 10; round++) {
+        for (uint32_t i = 0; i < 64; i++)
+            isPass &= (ring.enqueue(round * 64 + i) == STATUS_SUCCESS);
+        isPass &= ring.isFull() && (ring.getSize() == 64)
+                  && (ring.enqueue(0) == ERR_QUEUE_FULL);
+        for (uint32_t i = 0; i < 64; i++)
+            isPass &= (ring.dequeue(value) == STATUS_SUCCESS) && (value == round * 64 + i);
+        isPass &= ring.isEmpty();
+    }
+
+    // Producer and consumer threads: every element once, in order
+    const uint32_t count = std::max((size_t)1000000, rounds * 50);
+    std::vector<double> ns;
+    for (size_t b = 0; b < BATCHES; b++) {
+        uint32_t numReceived = 0;
+        bool isOrdered = true;
+        double start = nowNs();
+        std::thread consumer([&]() {
+            uint32_t data;
+            while (numReceived < count) {
+                if (ring.dequeue(data) != STATUS_SUCCESS) {
+                    std::this_thread::yield(); //< e.g. a single core
+                    continue;
+                }
+                isOrdered &= (data == numReceived);
+                numReceived++;
+            }
+        });
+        for (uint32_t i = 0; i < count; i++) {
+            while (ring.enqueue(i) != STATUS_SUCCESS)
+                std::this_thread::yield();
+        }
+        consumer.join();
+        ns.push_back((nowNs() - start) / count);
+        isPass &= isOrdered && (numReceived == count) && ring.isEmpty();
+    }
+    printCheck("spscRing", isPass);
+    printResult("spscRing", "\"size\":64", median(ns));
+}
+
+static void benchInventoryFrame()
+{
+    const size_t counts[] = { 1, 5, MAX_CARDS };
+
+    bool isPass = true;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        std::vector<TID> tids = randomTids(counts[c]);
+        std::vector<byte> frame = makeFrame(tids, STATUS_SUCCESS);
+
+        InventoryFrame view(frame.data());
+        std::vector<TID> expected = refParse(frame.data());
+        isPass &= (view.getStatus() == STATUS_SUCCESS)
+                  && (view.getNumCards() == expected.size());
+        size_t i = 0;
+        for (InventoryFrame::Iterator it = view.begin(); it != view.end(); ++it, ++i)
+            isPass &= (i < expected.size()) && (it.getKey() == packTid(expected[i]));
+
+        // A shorter Len byte cuts the last TID
+        std::vector<byte> cut(frame);
+        cut[RE_LENGTH_INDEX]--;
+        isPass &= (InventoryFrame(cut.data()).getStatus() == ERR_TID_SIZE);
+
+        double ns = measure([&](size_t i) {
+            InventoryFrame view(frame.data());
+            TidKey sum = 0;
+            for (InventoryFrame::Iterator it = view.begin(); it != view.end(); ++it)
+                sum += it.getKey();
+            sink = (uint32_t)sum;
+        }, rounds);
+
+        char params[32];
+        snprintf(params, sizeof(params), "\"cards\":%zu", counts[c]);
+        printResult("inventoryFrame", params, ns);
+    }
+    printCheck("inventoryFrame", isPass);
+}
+
+/* Set the status of every card of the database (e.g. printed to keyboard) */
+static void markPrinted(Database& database)
+{
+    CardQueue& cards = database.getDB();
+    for (CardQueue::Iterator it = cards.begin(); it != cards.end(); ++it)
+        it->status = true;
+}
+
+/* Compare the cards of the database (no expired card) with the model */
+static bool isSameDatabase(Database& database, RefDatabase& model)
+{
+    std::set<std::pair<std::string, bool> > actual;
+    CardQueue& cards = database.getDB();
+    for (CardQueue::Iterator it = cards.begin(); it != cards.end(); ++it)
+        actual.insert(std::make_pair(refToString(it->tid), it->status));
+
+    std::set<std::pair<std::string, bool> > expected(model.begin(), model.end());
+    return (actual == expected) && (cards.getSize() == model.size());
+}
+
+static void benchUpdateDB()
+{
+    const size_t counts[] = { 1, 5, MAX_CARDS };
+    const double hits[] = { 0.0, 0.5, 1.0 };
+
+    bool isPass = true;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        size_t numCards = counts[c];
+        if (numCards > DATABASE_CAPACITY)
+            continue;
+
+        const size_t fills[] = { DATABASE_CAPACITY / 2, DATABASE_CAPACITY - numCards };
+        for (size_t f = 0; f < 2; f++) {
+            size_t fill = fills[f];
+            for (size_t h = 0; h < sizeof(hits) / sizeof(hits[0]); h++) {
+                size_t numHits = (size_t)(numCards * hits[h] + 0.5);
+                if (numHits > fill)
+                    continue;
+
+                // Database: `fill` cards, a poll: `numHits` of them + new ones
+                std::vector<TID> stored = randomTids(fill);
+                std::vector<TID> poll = sliceTids(stored, fill - numHits, numHits);
+                std::vector<TID> fresh = randomTids(numCards - numHits);
+                poll.insert(poll.end(), fresh.begin(), fresh.end());
+                std::vector<byte> frame = makeFrame(poll, STATUS_SUCCESS);
+
+                std::vector<std::vector<byte> > fillFrames;
+                for (size_t i = 0; i < fill; i += MAX_CARDS) {
+                    size_t n = std::min((size_t)MAX_CARDS, fill - i);
+                    fillFrames.push_back(makeFrame(sliceTids(stored, i, n), STATUS_SUCCESS));
+                }
+
+                // A fresh database per poll keeps the hit ratio exact, only
+                // updateDB() is timed
+                size_t polls = std::max((size_t)50, rounds / 40);
+                polls = std::min(polls, std::max((size_t)20, 4000000 / (fill + 1)));
+
+                std::vector<double> ns;
+                for (size_t b = 0; b < BATCHES; b++) {
+                    double total = 0;
+                    for (size_t p = 0; p < polls; p++) {
+                        Database* database = new Database;
+                        for (size_t i = 0; i < fillFrames.size(); i++)
+                            database->updateDB(fillFrames[i].data());
+                        markPrinted(*database);
+
+                        double start = nowNs();
+                        database->updateDB(frame.data());
+                        total += nowNs() - start;
+
+                        if (b == 0 && p == 0) {
+                            RefDatabase model;
+                            refUpdate(model, stored);
+                            for (size_t j = 0; j < model.size(); j++)
+                                model[j].second = true;
+                            refUpdate(model, poll);
+                            isPass &= isSameDatabase(*database, model);
+
+                            // Every card expires at once
+                            database->sweepExpired(millis() + EXPIRE_TIME);
+                            database->updateDB(frame.data());
+                            RefDatabase expired;
+                            refUpdate(expired, poll);
+                            CardIndex live = 0;
+                            CardQueue& cards = database->getDB();
+                            for (CardQueue::Iterator it = cards.begin(); it != cards.end(); ++it)
+                                live += (it->status == false);
+                            isPass &= (live == expired.size());
+                        }
+                        delete database;
+                    }
+                    ns.push_back(total / polls);
+                }
+
+                char params[96];
+                snprintf(params, sizeof(params),
+                         "\"cards\":%zu,\"fill\":%zu,\"hit\":%.2f", numCards, fill, hits[h]);
+                printResult("updateDB", params, median(ns));
+            }
+        }
+    }
+    printCheck("updateDB", isPass);
+}
+
+static void benchRepeats()
+{
+    // Session of 2 frames: TIDs repeated in each frame and in both frames
+    std::vector<TID> tids = randomTids(8);
+    std::vector<TID> first = sliceTids(tids, 0, 6);
+    first.push_back(tids[0]);
+    first.push_back(tids[1]);
+    std::vector<TID> last = sliceTids(tids, 3, 5);
+    last.push_back(tids[4]);
+
+    Database* database = new Database;
+    database->beginSession();
+    database->updateDB(makeFrame(first, ERR_INV_FRAME_OUT).data());
+    database->updateDB(makeFrame(last, STATUS_SUCCESS).data());
+    RefDatabase model;
+    refUpdate(model, first);
+    refUpdate(model, last);
+    bool isPass = isSameDatabase(*database, model) && (database->getNumArrivals() == 8);
+
+    // A session aborted after its first frame, then every card expires: the
+    // TIDs of the aborted session are new again
+    database->updateDB(makeFrame(first, ERR_INV_FRAME_OUT).data());
+    database->sweepExpired(millis() + EXPIRE_TIME);
+    database->updateDB(makeFrame(first, STATUS_SUCCESS).data());
+    isPass &= (database->getNumArrivals() == 8 + 6);
+    delete database;
+    printCheck("repeats", isPass);
+
+    const size_t uniques[] = { MAX_CARDS, 5, 1 };
+    for (size_t u = 0; u < sizeof(uniques) / sizeof(uniques[0]); u++) {
+        std::vector<TID> distinct = randomTids(uniques[u]);
+        std::vector<TID> poll;
+        for (size_t i = 0; i < MAX_CARDS; i++)
+            poll.push_back(distinct[i % distinct.size()]);
+        std::vector<byte> frame = makeFrame(poll, STATUS_SUCCESS);
+
+        database = new Database;
+        std::vector<TID> stored = randomTids(DATABASE_CAPACITY / 2);
+        for (size_t i = 0; i < stored.size(); i += MAX_CARDS) {
+            size_t n = std::min((size_t)MAX_CARDS, stored.size() - i);
+            database->updateDB(makeFrame(sliceTids(stored, i, n), STATUS_SUCCESS).data());
+        }
+        database->updateDB(frame.data()); //< Known cards
+
+        double ns = measure([&](size_t i) {
+            (void)i;
+            database->updateDB(frame.data());
+        }, rounds);
+        delete database;
+
+        char params[48];
+        snprintf(params, sizeof(params), "\"cards\":%d,\"unique\":%zu", MAX_CARDS, uniques[u]);
+        printResult("repeats", params, ns);
+    }
+}
+
+static void benchEncoding()
+{
+    std::vector<TID> tids = randomTids(256);
+
+    bool isPass = true;
+    for (size_t i = 0; i < tids.size(); i++)
+        isPass &= (refToString(tids[i]) == toString(tids[i]).c_str());
+    printCheck("toString", isPass);
+
+    double ns = measure([&](size_t i) {
+        sink = toString(tids[i & 255]).length();
+    }, rounds);
+    printResult("toString", "\"bytes\":6", ns);
+
+    const char* prefixes[] = { "", "TT-" };
+    isPass = true;
+    for (size_t p = 0; p < 2; p++) {
+        for (size_t i = 0; i < tids.size(); i++) {
+            randomSeed(i + 1);
+            String hash = generateHash(tids[i], prefixes[p]);
+            randomSeed(i + 1);
+            isPass &= (refGenerateHash(tids[i], prefixes[p]) == hash.c_str());
+        }
+    }
+    printCheck("generateHash", isPass);
+
+    String prefix = "";
+    ns = measure([&](size_t i) {
+        sink = generateHash(tids[i & 255], prefix).length();
+    }, rounds);
+    printResult("generateHash", "\"bytes\":6", ns);
+
+    char buffer[KEYBOARD_BUFFER_SIZE];
+    TextBuffer text(buffer, sizeof(buffer));
+    isPass = true;
+    for (size_t i = 0; i < tids.size(); i++) {
+        text.clear();
+        printTid(text, packTid(tids[i]));
+        isPass &= (refToString(tids[i]) == text.c_str());
+    }
+    printCheck("printTid", isPass);
+
+    ns = measure([&](size_t i) {
+        text.clear();
+        printTid(text, packTid(tids[i & 255]));
+        sink = text.length();
+    }, rounds);
+    printResult("printTid", "\"bytes\":6", ns);
+
+    isPass = true;
+    for (size_t p = 0; p < 2; p++) {
+        for (size_t i = 0; i < tids.size(); i++) {
+            text.clear();
+            randomSeed(i + 1);
+            printHash(text, tids[i], prefixes[p]);
+            randomSeed(i + 1);
+            isPass &= (refGenerateHash(tids[i], prefixes[p]) == text.c_str());
+        }
+    }
+
+    // Text which does not fit is dropped, the rest is kept
+    char small[8];
+    TextBuffer truncated(small, sizeof(small));
+    truncated.print("0123");
+    isPass &= !truncated.isOverflowed();
+    truncated.print(4567L);
+    isPass &= truncated.isOverflowed() && (std::string(small) == "0123456")
+              && (truncated.getRoom() == 0);
+
+    // A poll of new cards allocates nothing
+    Keyboard.setOutput(-1);
+    Database* database = new Database;
+    std::vector<byte> frame = makeFrame(sliceTids(tids, 0, std::min(5, DATABASE_CAPACITY)),
+                                        STATUS_SUCCESS);
+    size_t before = numAllocations;
+    database->updateDB(frame.data());
+    database->printToKeyboard();
+    database->getKeyboard().run();
+    isPass &= (numAllocations == before);
+    delete database;
+    printCheck("printHash", isPass);
+
+    // The token of a card is drawn when it arrives: it decodes to the TID
+    // and does not change until the card expires
+    database = new Database;
+    database->begin();
+    size_t numCards = std::min(15, DATABASE_CAPACITY);
+    frame = makeFrame(sliceTids(tids, 0, numCards), STATUS_SUCCESS);
+    database->updateDB(frame.data());
+    std::vector<std::string> tokens;
+    isPass = (database->getDB().getSize() == numCards);
+    for (CardQueue::Iterator it = database->getDB().begin(); it != database->getDB().end(); ++it) {
+        text.clear();
+        database->printToken(text, *it);
+        tokens.push_back(text.c_str());
+
+        std::vector<byte> data;
+        for (size_t j = 0; j + 3 <= tokens.back().size(); j += 3)
+            data.push_back((byte)atoi(tokens.back().substr(j, 3).c_str()));
+        bool isDecoded = (data.size() == it->tid.size + 2u);
+        for (size_t j = 0; isDecoded && (j < 2); j++)
+            isDecoded = (data[it->tid.size + j] >= 1) && (data[it->tid.size + j] <= 254);
+        for (size_t j = 0; isDecoded && (j < it->tid.size); j++)
+            isDecoded = ((data[j] ^ data[it->tid.size + j % 2]) == it->tid.tidByte[j]);
+        isPass &= isDecoded;
+    }
+    isPass &= (std::set<std::string>(tokens.begin(), tokens.end()).size() == numCards);
+    database->updateDB(frame.data());
+    database->printToKeyboard();
+    database->getKeyboard().run();
+    size_t t = 0;
+    for (CardQueue::Iterator it = database->getDB().begin(); it != database->getDB().end(); ++it) {
+        text.clear();
+        database->printToken(text, *it);
+        isPass &= (tokens[t++] == text.c_str());
+    }
+    printCheck("printToken", isPass);
+
+    Card* cards = database->getDB().getQueueData();
+    ns = measure([&](size_t i) {
+        text.clear();
+        database->printToken(text, cards[i % numCards]);
+        sink = text.length();
+    }, rounds);
+    delete database;
+    printResult("printToken", "\"bytes\":6", ns);
+
+    ns = measure([&](size_t i) {
+        text.clear();
+        printHash(text, tids[i & 255], "");
+        sink = text.length();
+    }, rounds);
+    printResult("printHash", "\"bytes\":6", ns);
+
+    const TokenEncoding encodings[] = { TOKEN_DECIMAL, TOKEN_HEX, TOKEN_BASE32 };
+    const char* names[] = { "decimal", "hex", "base32" };
+    isPass = true;
+    for (size_t e = 0; e < 3; e++) {
+        for (size_t c = 0; c < 2; c++) {
+            for (size_t i = 0; i < tids.size(); i++) {
+                TID tid = tids[i];
+                tid.size = 1 + i % MAX_SIZE_TID; //< Every number of bits
+                text.clear();
+                randomSeed(i + 1);
+                printHash(text, tid, "TT-", encodings[e], c == 1);
+                randomSeed(i + 1);
+                isPass &= (("TT-" + refToken(refHashBytes(tid), encodings[e], c == 1))
+                           == text.c_str());
+            }
+        }
+    }
+    printCheck("token", isPass);
+
+    for (size_t e = 0; e < 3; e++) {
+        ns = measure([&](size_t i) {
+            text.clear();
+            printHash(text, tids[i & 255], "", encodings[e], true);
+            sink = text.length();
+        }, rounds);
+
+        char params[48];
+        snprintf(params, sizeof(params), "\"encoding\":\"%s\",\"chars\":%zu",
+                 names[e], text.length());
+        printResult("token", params, ns);
+    }
+}
+
+/* Read what was written to a pipe */
+static std::string readPipe(int fd)
+{
+    std::string text;
+    char buffer[256];
+    ssize_t size;
+    while ((size = read(fd, buffer, sizeof(buffer))) > 0)
+        text.append(buffer, size);
+    return text;
+}
+
+/* Type the tokens of the new cards of a database, return the time (ns) */
+static double clearArrival(Database& database)
+{
+    double start = nowNs();
+    bool isCleared = false;
+    while (!isCleared) {
+        database.printToKeyboard();
+        database.getKeyboard().run();
+
+        isCleared = database.getKeyboard().isIdle();
+        for (CardQueue::Iterator it = database.getDB().begin(); it != database.getDB().end(); ++it)
+            isCleared &= it->status;
+    }
+    return nowNs() - start;
+}
+
+static void checkPollController()
+{
+    // Outcome of a session and the period (ms) expected after it, with
+    // limits of 50 to 1000 ms, a patience of 2 and a shift of 1
+    struct {
+        Status status;
+        uint16_t newCards;
+        uint16_t period;
+    } steps[] = {
+        { STATUS_SUCCESS, 0, 57 },      //< Known cards: + 1/8 + 1
+        { STATUS_SUCCESS, 0, 65 },
+        { STATUS_SUCCESS, 3, 50 },      //< Arrivals: minimum
+        { STATUS_RS485_BUSY, 0, 50 },   //< Not finished: unchanged
+        { ERR_INV_NO_CARD, 0, 50 },     //< Patience
+        { ERR_INV_NO_CARD, 0, 50 },
+        { ERR_INV_NO_CARD, 0, 76 },     //< Backs off: + 1/2 + 1
+        { ERR_INV_NO_CARD, 0, 115 },
+        { ERR_INV_TIMEOUT, 0, 50 },     //< Tags left unreported: minimum
+        { STATUS_SUCCESS, 0, 57 },
+        { ERR_CRC, 0, 50 },             //< First failure: minimum
+        { ERR_CRC, 0, 101 },            //< Then doubles (+ 1)
+        { ERR_RS485_TIMEOUT, 0, 203 },
+        { ERR_CRC, 0, 407 },
+        { ERR_CRC, 0, 815 },
+        { ERR_CRC, 0, 1000 },           //< Clamped to the maximum
+        { ERR_CRC, 0, 1000 },
+        { ERR_INV_NO_CARD, 0, 1000 },
+        { ERR_INV_NO_CARD, 0, 1000 },
+        { ERR_INV_NO_CARD, 0, 1000 },   //< Backs off, still the maximum
+        { ERR_INV_MEM_OUT, 0, 50 },
+        { ERR_CRC, 0, 50 },             //< Failure after a success: minimum
+    };
+
+    PollController rate;
+    rate.setLimits(50, 1000);
+    rate.setAggressiveness(2, 1);
+    bool isPass = (rate.getPeriod() == 50);
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        rate.update(steps[i].status, steps[i].newCards);
+        isPass &= (rate.getPeriod() == steps[i].period);
+    }
+
+    // New limits clamp the current period, at both ends
+    rate.update(STATUS_SUCCESS, 0);
+    rate.update(ERR_CRC, 0);
+    rate.update(ERR_CRC, 0); //< 101 ms
+    rate.setLimits(200, 300);
+    isPass &= (rate.getPeriod() == 200);
+    rate.update(ERR_CRC, 0);
+    isPass &= (rate.getPeriod() == 300);
+    rate.setLimits(10, 100);
+    isPass &= (rate.getPeriod() == 100);
+    rate.update(STATUS_SUCCESS, 1);
+    isPass &= (rate.getPeriod() == 10);
+    printCheck("pollController", isPass);
+}
+
+static void benchKeyboard()
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        printCheck("keyboard", false);
+        return;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    Keyboard.setOutput(fds[1]);
+
+    // Default pacing: one token, then a pause
+    KeyboardScheduler keyboard;
+    const char* tokens[] = { "A", "B", "C", "D", "E", "F" };
+    keyboard.enqueue(tokens[0]);
+    keyboard.enqueue(tokens[1]);
+    for (size_t i = 0; i < 10; i++)
+        keyboard.run();
+    bool isPass = (readPipe(fds[0]) == "A\n") && (keyboard.getKeysPerSecond() == 0);
+
+    // Bursts of 4 tokens, then the rest once the pause is over
+    keyboard.setBurst(4, ',');
+    keyboard.setPacing(0, 0, 255);
+    for (size_t i = 2; i < 6; i++)
+        keyboard.enqueue(tokens[i]);
+    keyboard.run();
+    keyboard.setPacing(60000, 0, 255);
+    for (size_t i = 0; i < 10; i++)
+        keyboard.run();
+    isPass &= (readPipe(fds[0]) == "B,C,D,E,");
+    keyboard.setPacing(0, 0, 255);
+    for (size_t i = 0; i < 10; i++)
+        keyboard.run();
+    isPass &= (readPipe(fds[0]) == "F,") && keyboard.isIdle();
+
+    // Rate: a queue typed within one tick (64 us) does not count, 4
+    // keystrokes 100 us apart are typed in at least 300 us (4 ticks)
+    KeyboardScheduler paced;
+    paced.setBurst(255, ',');
+    paced.setPacing(0, 100, 255);
+    paced.enqueue("");
+    paced.run();
+    isPass &= (readPipe(fds[0]) == ",") && (paced.getKeysPerSecond() == 0);
+
+    paced.enqueue("ABC");
+    for (uint32_t start = millis(); !paced.isIdle() && (millis() - start < 100); )
+        paced.run();
+    isPass &= (readPipe(fds[0]) == "ABC,") && (paced.getKeysPerSecond() > 0)
+              && (paced.getKeysPerSecond() <= 4 * 15625 / (300 / 64)); //< In ticks
+
+    // An arrival is typed as the tokens of the cards, each one followed by
+    // the separator
+    size_t numCards = std::min(MAX_CARDS, DATABASE_CAPACITY);
+    std::vector<byte> frame = makeFrame(randomTids(numCards), STATUS_SUCCESS);
+    Database* database = new Database;
+    database->getKeyboard().setBurst(MAX_CARDS, '\t');
+    database->getKeyboard().setPacing(0, 0, 255);
+    database->updateDB(frame.data());
+    clearArrival(*database);
+
+    std::string expected;
+    char buffer[KEYBOARD_BUFFER_SIZE];
+    TextBuffer text(buffer, sizeof(buffer));
+    for (CardQueue::Iterator it = database->getDB().begin(); it != database->getDB().end(); ++it) {
+        text.clear();
+        database->printToken(text, *it);
+        expected += std::string(text.c_str()) + "\t";
+    }
+    isPass &= (readPipe(fds[0]) == expected);
+    delete database;
+
+    Keyboard.setOutput(-1);
+    close(fds[0]);
+    close(fds[1]);
+    printCheck("keyboard", isPass);
+
+    // Time to type an arrival, in bursts of 8 cards 20 ms apart
+    std::vector<double> ns;
+    uint16_t keysPerSecond = 0;
+    for (size_t b = 0; b < 3; b++) {
+        database = new Database;
+        database->getKeyboard().setBurst(8, '\n');
+        database->getKeyboard().setPacing(20, 0, 16);
+        database->updateDB(frame.data());
+        ns.push_back(clearArrival(*database));
+        keysPerSecond = database->getKeyboard().getKeysPerSecond();
+        delete database;
+    }
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"cards\":%zu,\"burst\":8,\"keysPerSecond\":%u",
+             numCards, keysPerSecond);
+    printResult("keyboard", params, median(ns));
+}
+
+/* Keep the events of a database */
+static void recordEvent(const CardEvent& event, void* context)
+{
+    ((std::vector<CardEvent>*)context)->push_back(event);
+}
+
+/* Return true if the events are the given events of the given TIDs */
+static bool isSameEvents(Database& database, const std::vector<CardEvent>& events,
+                         CardEventType type, const std::vector<TID>& tids)
+{
+    std::multiset<TidKey> actual, expected;
+    Card* cards = database.getDB().getQueueData();
+    for (size_t i = 0; i < events.size(); i++) {
+        if ((events[i].type != type) || (packTid(cards[events[i].slot].tid) != events[i].key))
+            return false;
+        actual.insert(events[i].key);
+    }
+    for (size_t i = 0; i < tids.size(); i++)
+        expected.insert(packTid(tids[i]));
+    return actual == expected;
+}
+
+static void benchEvents()
+{
+    // Arrivals, then a known card and a new card, then every card leaves
+    std::vector<TID> tids = randomTids(std::min(4, DATABASE_CAPACITY));
+    std::vector<TID> first = sliceTids(tids, 0, tids.size() - 1);
+    std::vector<TID> known = sliceTids(tids, 0, 1);
+    std::vector<TID> fresh = sliceTids(tids, tids.size() - 1, 1);
+    std::vector<CardEvent> events;
+
+    Database* database = new Database;
+    database->setEventCallback(recordEvent, &events);
+    database->updateDB(makeFrame(first, STATUS_SUCCESS).data());
+    bool isPass = isSameEvents(*database, events, CARD_ARRIVED, first);
+    Card* cards = database->getDB().getQueueData();
+    for (size_t i = 0; i < events.size(); i++)
+        isPass &= (events[i].time == cards[events[i].slot].time);
+
+    events.clear();
+    known.push_back(fresh[0]);
+    database->updateDB(makeFrame(known, STATUS_SUCCESS).data());
+    isPass &= (events.size() == 2)
+              && isSameEvents(*database, std::vector<CardEvent>(1, events[0]),
+                              CARD_REFRESHED, sliceTids(tids, 0, 1))
+              && isSameEvents(*database, std::vector<CardEvent>(1, events[1]),
+                              CARD_ARRIVED, fresh);
+
+    events.clear();
+    uint32_t now = millis() + EXPIRE_TIME;
+    database->sweepExpired(now);
+    isPass &= isSameEvents(*database, events, CARD_LEFT, tids) && (events.back().time == now);
+    delete database;
+
+    // More arrivals than the database can hold before printToKeyboard() (a
+    // card comes and goes, always in the same slot): the cards still
+    // connected are typed once
+    int fds[2];
+    if (pipe(fds) != 0) {
+        printCheck("events", false);
+        return;
+    }
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    Keyboard.setOutput(fds[1]);
+
+    database = new Database;
+    database->getKeyboard().setBurst(255, '\n');
+    database->getKeyboard().setPacing(0, 0, 255);
+    size_t numCards = std::min(MAX_CARDS, DATABASE_CAPACITY);
+    for (size_t i = 0; i <= DATABASE_CAPACITY; i++) {
+        database->sweepExpired(millis() + EXPIRE_TIME);
+        database->updateDB(makeFrame(randomTids((i < DATABASE_CAPACITY) ? 1 : numCards),
+                                     STATUS_SUCCESS).data());
+    }
+    for (size_t i = 0; i < 4; i++) {
+        database->printToKeyboard();
+        database->getKeyboard().run();
+    }
+    std::string typed = readPipe(fds[0]);
+    isPass &= ((size_t)std::count(typed.begin(), typed.end(), '\n') == numCards);
+    delete database;
+
+    Keyboard.setOutput(-1);
+    close(fds[0]);
+    close(fds[1]);
+    printCheck("events", isPass);
+
+    // printToKeyboard() when no card arrived, the database is full
+    database = new Database;
+    std::vector<TID> stored = randomTids(DATABASE_CAPACITY);
+    for (size_t i = 0; i < stored.size(); i += MAX_CARDS) {
+        size_t n = std::min((size_t)MAX_CARDS, stored.size() - i);
+        database->updateDB(makeFrame(sliceTids(stored, i, n), STATUS_SUCCESS).data());
+    }
+    markPrinted(*database);
+    database->printToKeyboard();
+
+    double ns = measure([&](size_t i) {
+        database->printToKeyboard();
+    }, rounds);
+    delete database;
+
+    char params[32];
+    snprintf(params, sizeof(params), "\"fill\":%d", DATABASE_CAPACITY);
+    printResult("printToKeyboard", params, ns);
+}
+
+/* Storage in RAM, writes are dropped after `budget` bytes (power loss) */
+class RamStorage: public Storage
+{
+public:
+    RamStorage(size_t size): data(size, 0xFF), budget((size_t)-1), numWritten(0) {}
+
+    size_t getSize() override
+    {
+        return data.size();
+    }
+
+    void read(const size_t address, byte* bytes, const size_t size) override
+    {
+        memcpy(bytes, data.data() + address, size);
+    }
+
+    void write(const size_t address, const byte* bytes, const size_t size) override
+    {
+        for (size_t i = 0; (i < size) && (numWritten < budget); i++) {
+            data[address + i] = bytes[i];
+            numWritten++;
+        }
+    }
+
+    std::vector<byte> data;
+    size_t budget;
+    size_t numWritten;
+};
+
+/* Counts the bytes written to another storage */
+class MeteredStorage: public Storage
+{
+public:
+    MeteredStorage(Storage& storage): storage(storage), numWritten(0) {}
+
+    size_t getSize() override
+    {
+        return storage.getSize();
+    }
+
+    void read(const size_t address, byte* bytes, const size_t size) override
+    {
+        storage.read(address, bytes, size);
+    }
+
+    void write(const size_t address, const byte* bytes, const size_t size) override
+    {
+        storage.write(address, bytes, size);
+        numWritten += size;
+    }
+
+    void commit() override
+    {
+        storage.commit();
+    }
+
+    Storage& storage;
+    size_t numWritten;
+};
+
+typedef std::set<TidKey> KeySet;
+
+static void applyRecord(JournalOp op, TidKey key, void* context)
+{
+    KeySet* keys = (KeySet*)context;
+    if (op == JOURNAL_PRINTED)
+        keys->insert(key);
+    else
+        keys->erase(key);
+}
+
+/* Typed cards kept in a storage */
+static KeySet loadKeys(Storage& storage)
+{
+    KeySet keys;
+    DatabaseJournal journal(storage);
+    if (journal.begin() == STATUS_SUCCESS)
+        journal.replay(applyRecord, &keys);
+    return keys;
+}
+
+/*
+* Visitors arrive and are typed, some come back, everybody leaves every 5
+* visits. The typed cards after each change are appended to `states`. A few
+* loop() run between 2 visits, so snapshots may be written while cards
+* change. Returns the most bytes written by one sync() (`SIZE_MAX` if
+* anything else writes).
+*/
+static size_t runVisits(Storage& storage, std::vector<KeySet>& states)
+{
+    _seed = 7;
+    std::vector<TID> regulars = randomTids(8);
+
+    Database* database = new Database;
+    MeteredStorage metered(storage);
+    DatabaseJournal journal(metered);
+    database->restore(journal);
+
+    KeySet typed;
+    std::vector<TidKey> seen; //< Order of the expiry list
+    states.assign(1, typed);
+    size_t maxSyncBytes = 0;
+
+    for (size_t visit = 1; visit <= 42; visit++) {
+        size_t numChanged = metered.numWritten;
+        std::vector<TID> tids = randomTids(1 + visit % 3);
+        if (visit % 2 == 0)
+            tids.push_back(regulars[visit % regulars.size()]);
+        database->updateDB(makeFrame(tids, STATUS_SUCCESS).data());
+
+        for (size_t i = 0; i < tids.size(); i++) {
+            TidKey key = packTid(tids[i]);
+            seen.erase(std::remove(seen.begin(), seen.end(), key), seen.end());
+            seen.push_back(key);
+        }
+
+        CardQueue& cards = database->getDB();
+        for (CardQueue::Iterator it = cards.begin(); it != cards.end(); ++it) {
+            if (it->status == false) {
+                database->markPrinted(*it);
+                typed.insert(packTid(it->tid));
+                states.push_back(typed);
+            }
+        }
+
+        if (visit % 5 == 0) {
+            database->sweepExpired(millis() + EXPIRE_TIME);
+            for (size_t i = 0; i < seen.size(); i++) {
+                typed.erase(seen[i]);
+                states.push_back(typed);
+            }
+            seen.clear();
+        }
+
+        // Only sync() writes to the storage
+        if (metered.numWritten != numChanged)
+            maxSyncBytes = SIZE_MAX;
+        for (size_t loop = 0; loop < 8; loop++) {
+            size_t numWritten = metered.numWritten;
+            database->sync(millis() + (visit % 3 == 0) * JOURNAL_FLUSH_PERIOD);
+            maxSyncBytes = std::max(maxSyncBytes, metered.numWritten - numWritten);
+        }
+    }
+
+    // Write the last changes, until sync() has nothing left to write
+    size_t numWritten;
+    do {
+        numWritten = metered.numWritten;
+        database->sync(millis() + JOURNAL_FLUSH_PERIOD);
+    } while (metered.numWritten != numWritten);
+    delete database;
+    return maxSyncBytes;
+}
+
+static void benchRestore()
+{
+    // Room for a few batches, so that the visits write several snapshots
+    size_t size = DatabaseJournal::getMinSize() + 12 * (MAX_SIZE_TID + 4);
+
+    std::vector<KeySet> states;
+    RamStorage full(size);
+    size_t maxSyncBytes = runVisits(full, states);
+    bool isPass = (loadKeys(full) == states.back());
+    isPass &= (maxSyncBytes > 0) && (maxSyncBytes <= JOURNAL_SYNC_BYTES);
+
+    // Power loss: only cards which were typed are restored. A snapshot
+    // written while cards change may mix 2 states of the visits (the
+    // journal written after it has the difference).
+    KeySet everTyped;
+    for (size_t i = 0; i < states.size(); i++)
+        everTyped.insert(states[i].begin(), states[i].end());
+    size_t step = std::max((size_t)1, full.numWritten / 400);
+    for (size_t budget = 0; budget < full.numWritten; budget += step) {
+        RamStorage storage(size);
+        storage.budget = budget;
+        std::vector<KeySet> ignored;
+        runVisits(storage, ignored);
+        KeySet keys = loadKeys(storage);
+        isPass &= std::includes(everTyped.begin(), everTyped.end(),
+                                keys.begin(), keys.end());
+    }
+
+    if (DatabaseJournal::getMinSize() <= EEPROM.length()) {
+        EEPROM.erase();
+        EepromStorage eeprom(0, EEPROM.length());
+        runVisits(eeprom, states);
+        isPass &= (loadKeys(eeprom) == states.back());
+    }
+
+    char path[] = "/tmp/uhf_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+        MappedFileStorage file;
+        isPass &= file.open(path, size);
+        runVisits(file, states);
+        file.close();
+        isPass &= file.open(path, size);
+        isPass &= (loadKeys(file) == states.back());
+        file.close();
+        unlink(path);
+    }
+
+    // Storage of a database filled with typed cards (room for a new one)
+    std::vector<TID> tids = randomTids(DATABASE_CAPACITY - 1);
+    RamStorage filled(size);
+    Database* database = new Database;
+    DatabaseJournal journal(filled);
+    database->restore(journal);
+    for (size_t i = 0; i < tids.size(); i += MAX_CARDS) {
+        size_t n = std::min((size_t)MAX_CARDS, tids.size() - i);
+        database->updateDB(makeFrame(sliceTids(tids, i, n), STATUS_SUCCESS).data());
+    }
+    markPrinted(*database);
+    database->checkpoint();
+    delete database;
+
+    // After a restart, the typed cards in the field are not new
+    RamStorage restarted = filled;
+    database = new Database;
+    DatabaseJournal restartedJournal(restarted);
+    isPass &= (database->restore(restartedJournal) == STATUS_SUCCESS);
+    std::vector<TID> poll = sliceTids(tids, 0, std::min((size_t)MAX_CARDS - 1, tids.size()));
+    poll.push_back(randomTid());
+    database->updateDB(makeFrame(poll, STATUS_SUCCESS).data());
+    size_t numNew = 0;
+    CardQueue& cards = database->getDB();
+    for (CardQueue::Iterator it = cards.begin(); it != cards.end(); ++it)
+        numNew += (it->status == false);
+    isPass &= (database->getNumArrivals() == 1) && (numNew == 1);
+    delete database;
+
+    // Tokens queued but not typed yet are typed again after a reset
+    RamStorage typing(size);
+    database = new Database;
+    DatabaseJournal typingJournal(typing);
+    database->restore(typingJournal);
+    database->updateDB(makeFrame(randomTids(2), STATUS_SUCCESS).data());
+    KeyboardScheduler& keyboard = database->getKeyboard();
+    Keyboard.setOutput(-1);
+    keyboard.setBurst(1, '\n');
+    keyboard.setPacing(60000, 0, 255);
+    database->printToKeyboard();
+    database->checkpoint();
+    isPass &= loadKeys(typing).empty();
+
+    keyboard.run(); //< Types the first token, then pauses
+    database->checkpoint();
+    KeySet first;
+    first.insert(packTid(database->getDB().getQueueData()[0].tid));
+    isPass &= (loadKeys(typing) == first);
+
+    keyboard.setPacing(0, 0, 255);
+    keyboard.run();
+    database->sync(millis()); //< Records the second token
+    for (size_t loop = 0; loop < 100; loop++)
+        database->sync(millis() + JOURNAL_FLUSH_PERIOD);
+    isPass &= (loadKeys(typing).size() == 2);
+    delete database;
+    printCheck("restore", isPass);
+
+    size_t restarts = std::max((size_t)5, rounds / 100);
+    std::vector<double> ns;
+    for (size_t b = 0; b < BATCHES; b++) {
+        double total = 0;
+        for (size_t r = 0; r < restarts; r++) {
+            RamStorage storage = filled;
+            Database* restored = new Database;
+            DatabaseJournal restoredJournal(storage);
+
+            double start = nowNs();
+            restored->restore(restoredJournal);
+            total += nowNs() - start;
+            delete restored;
+        }
+        ns.push_back(total / restarts);
+    }
+
+    char params[32];
+    snprintf(params, sizeof(params), "\"cards\":%zu", tids.size());
+    printResult("restore", params, median(ns));
+}
+
+int main(int argc, char* argv[])
+{
+    int option;
+    while ((option = getopt(argc, argv, "l:r:o:")) != -1) {
+        if (option == 'l') {
+            label = optarg;
+        } else if (option == 'r') {
+            rounds = std::max(1L, atol(optarg));
+        } else if (option == 'o') {
+            out = fopen(optarg, "a");
+            if (out == NULL) {
+                perror(optarg);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [-l label] [-r rounds] [-o file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    HardwareSerial serial;
+    UHFRecv uhf(serial, DEFAULT_BAUD_RATE, DEFAULT_RS485_CTL_PIN);
+
+    benchCrc();
+    benchCommand(uhf);
+    benchIsDataPreserved(uhf);
+    checkStreamingCrc();
+    benchSpscRing();
+    benchInventoryFrame();
+    benchUpdateDB();
+    benchRepeats();
+    benchEncoding();
+    checkPollController();
+    benchKeyboard();
+    benchEvents();
+    benchRestore();
+
+    fclose(out);
+    return isPassed ? 0 : 1;
+}
@@ -0,0 +1,330 @@
+#include "Arduino.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Time */
+static uint64_t _monotonicMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static const uint64_t _startMicros = _monotonicMicros();
+
+uint32_t millis()
+{
+    return (uint32_t)((_monotonicMicros() - _startMicros) / 1000);
+}
+
+uint32_t micros()
+{
+    return (uint32_t)(_monotonicMicros() - _startMicros);
+}
+
+void delay(uint32_t ms)
+{
+    usleep((useconds_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    usleep(us);
+}
+
+/* Random numbers */
+long random(long max)
+{
+    return (max > 0) ? (::random() % max) : 0;
+}
+
+long random(long min, long max)
+{
+    return (max > min) ? (min + random(max - min)) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed != 0)
+        srandom((unsigned int)seed);
+}
+
+/* GPIO */
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    (void)pin;
+    (void)value;
+}
+
+int analogRead(uint8_t pin)
+{
+    (void)pin;
+    return (int)((_monotonicMicros() ^ (uint64_t)getpid()) & 0x3FF);
+}
+
+/* Numbers */
+#define NUMBER_SIZE                  (8 * sizeof(unsigned long) + 2)
+
+/* Format a number at the end of `buffer` (NUMBER_SIZE chars), return its start */
+static char* _formatNumber(char* buffer, unsigned long value, unsigned char base,
+                           bool isNegative)
+{
+    if (base < 2 || base > 36)
+        base = DEC;
+
+    char* p = buffer + NUMBER_SIZE - 1;
+    *p = '\0';
+    do {
+        byte digit = value % base;
+        *--p = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
+        value /= base;
+    } while (value != 0);
+
+    if (isNegative)
+        *--p = '-';
+    return p;
+}
+
+static char* _formatNumber(char* buffer, long value, unsigned char base)
+{
+    // Negative numbers are printed with a sign in base 10 only (as Arduino)
+    if (value < 0 && base == DEC)
+        return _formatNumber(buffer, -(unsigned long)value, base, true);
+    return _formatNumber(buffer, (unsigned long)value, base, false);
+}
+
+/* String */
+static std::string _toString(unsigned long value, unsigned char base, bool isNegative)
+{
+    char buffer[NUMBER_SIZE];
+    return std::string(_formatNumber(buffer, value, base, isNegative));
+}
+
+static std::string _toString(long value, unsigned char base)
+{
+    char buffer[NUMBER_SIZE];
+    return std::string(_formatNumber(buffer, value, base));
+}
+
+String::String(unsigned char value, unsigned char base): _str(_toString((unsigned long)value, base, false)) {}
+String::String(int value, unsigned char base): _str(_toString((long)value, base)) {}
+String::String(unsigned int value, unsigned char base): _str(_toString((unsigned long)value, base, false)) {}
+String::String(long value, unsigned char base): _str(_toString(value, base)) {}
+String::String(unsigned long value, unsigned char base): _str(_toString(value, base, false)) {}
+
+/* Print */
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) {
+        if (write(*buffer++) == 0)
+            break;
+        n++;
+    }
+    return n;
+}
+
+// Numbers are formatted on the stack (as Arduino), not in a String
+size_t Print::print(unsigned char value, int base) { return print((unsigned long)value, base); }
+size_t Print::print(int value, int base) { return print((long)value, base); }
+size_t Print::print(unsigned int value, int base) { return print((unsigned long)value, base); }
+
+size_t Print::print(long value, int base)
+{
+    char buffer[NUMBER_SIZE];
+    return write(_formatNumber(buffer, value, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    char buffer[NUMBER_SIZE];
+    return write(_formatNumber(buffer, value, (unsigned char)base, false));
+}
+
+/* HardwareSerial */
+HardwareSerial::HardwareSerial(): _fd(-1), _isOwner(false), _rxHead(0), _rxTail(0) {}
+
+HardwareSerial::HardwareSerial(int fd): _fd(-1), _isOwner(false), _rxHead(0), _rxTail(0)
+{
+    attach(fd);
+}
+
+HardwareSerial::~HardwareSerial()
+{
+    close();
+}
+
+bool HardwareSerial::open(const char* path)
+{
+    close();
+
+    int fd = ::open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    _fd = fd;
+    _isOwner = true;
+    return true;
+}
+
+void HardwareSerial::attach(int fd)
+{
+    close();
+
+    _fd = fd;
+    _isOwner = false;
+}
+
+void HardwareSerial::close()
+{
+    if (_isOwner && _fd >= 0)
+        ::close(_fd);
+    _fd = -1;
+    _isOwner = false;
+    _rxHead = 0;
+    _rxTail = 0;
+}
+
+static speed_t _toSpeed(unsigned long baud)
+{
+    switch (baud) {
+        case 9600:   return B9600;
+        case 19200:  return B19200;
+        case 38400:  return B38400;
+        case 57600:  return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        default:     return B57600;
+    }
+}
+
+/*
+* Raw mode, `config` is one of SERIAL_8xx (only 8 data bits are supported).
+* Attached descriptors (e.g. `Serial` on the console) are left as they are.
+*/
+void HardwareSerial::begin(unsigned long baud, uint8_t config)
+{
+    if (!_isOwner || !isatty(_fd))
+        return;
+
+    struct termios tty;
+    if (tcgetattr(_fd, &tty) != 0)
+        return;
+
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~(PARENB | PARODD | CSTOPB);
+    if (config & 0x20)
+        tty.c_cflag |= PARENB;
+    if ((config & 0x30) == 0x30)
+        tty.c_cflag |= PARODD;
+    if (config & 0x08)
+        tty.c_cflag |= CSTOPB;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+
+    cfsetispeed(&tty, _toSpeed(baud));
+    cfsetospeed(&tty, _toSpeed(baud));
+    tcsetattr(_fd, TCSANOW, &tty);
+}
+
+void HardwareSerial::end()
+{
+    close();
+}
+
+int HardwareSerial::available()
+{
+    if (_fd < 0)
+        return 0;
+
+    int count = 0;
+    if (ioctl(_fd, FIONREAD, &count) != 0)
+        count = 0;
+    return count + (_rxTail - _rxHead);
+}
+
+int HardwareSerial::read()
+{
+    if (_rxHead == _rxTail && !_fill())
+        return -1;
+    return _rx[_rxHead++];
+}
+
+int HardwareSerial::peek()
+{
+    if (_rxHead == _rxTail && !_fill())
+        return -1;
+    return _rx[_rxHead];
+}
+
+/* Read the pending bytes into `_rx` (one system call for a whole frame) */
+bool HardwareSerial::_fill()
+{
+    _rxHead = 0;
+    _rxTail = 0;
+
+    // Never block, even if the descriptor is in blocking mode
+    int count = 0;
+    if (_fd < 0 || ioctl(_fd, FIONREAD, &count) != 0 || count <= 0)
+        return false;
+
+    if (count > (int)sizeof(_rx))
+        count = sizeof(_rx);
+    ssize_t n = ::read(_fd, _rx, count);
+    if (n <= 0)
+        return false;
+
+    _rxTail = n;
+    return true;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    return (_fd >= 0) ? 64 : 0;
+}
+
+/* Wait until every byte is written */
+void HardwareSerial::flush()
+{
+    if (_fd >= 0 && isatty(_fd))
+        tcdrain(_fd);
+}
+
+size_t HardwareSerial::write(uint8_t data)
+{
+    return write(&data, 1);
+}
+
+/* Retry until every byte is written (as Arduino, write() blocks if full) */
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    size_t n = 0;
+    while (_fd >= 0 && n < size) {
+        ssize_t written = ::write(_fd, buffer + n, size - n);
+        if (written > 0) {
+            n += written;
+        } else if (written < 0 && (errno == EAGAIN || errno == EINTR)) {
+            struct pollfd pfd = { _fd, POLLOUT, 0 };
+            poll(&pfd, 1, 10);
+        } else {
+            break;
+        }
+    }
+    return n;
+}
+
+HardwareSerial Serial(STDOUT_FILENO);
+HardwareSerial Serial1;
@@ -0,0 +1,197 @@
+/*
+* Host (Linux) implementation of the subset of the Arduino core used by this
+* library, so the library builds and runs on a PC (see `CMakeLists.txt`).
+*
+* - Time: millis()/micros() are based on CLOCK_MONOTONIC.
+* - GPIO: pinMode()/digitalWrite() do nothing (USB/RS485 adapters switch the
+*   direction of the bus by themselves), analogRead() returns noise for
+*   randomSeed().
+* - HardwareSerial: a POSIX file descriptor (serial port, pty, pipe or
+*   socket). See `HardwareSerial::open()`.
+* - Serial: standard output.
+*/
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH                         0x1
+#define LOW                          0x0
+
+#define INPUT                        0x0
+#define OUTPUT                       0x1
+
+#define A0                           14
+
+#define DEC                          10
+#define HEX                          16
+#define OCT                          8
+#define BIN                          2
+
+// Serial configurations (same values as the AVR core)
+#define SERIAL_8N1                   0x06
+#define SERIAL_8N2                   0x0E
+#define SERIAL_8E1                   0x26
+#define SERIAL_8E2                   0x2E
+#define SERIAL_8O1                   0x36
+#define SERIAL_8O2                   0x3E
+
+#define PROGMEM
+#define pgm_read_byte(addr)          (*(const uint8_t*)(addr))
+#define pgm_read_word(addr)          (*(const uint16_t*)(addr))
+
+#define lowByte(w)                   ((uint8_t)((w) & 0xFF))
+#define highByte(w)                  ((uint8_t)((w) >> 8))
+
+/* Time */
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+/* Random numbers */
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/* GPIO */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int analogRead(uint8_t pin);
+
+/* Arduino `String`, backed by `std::string` */
+class String
+{
+public:
+    String() {}
+    String(const char* str): _str(str ? str : "") {}
+    String(const std::string& str): _str(str) {}
+    explicit String(char c): _str(1, c) {}
+    String(unsigned char value, unsigned char base = DEC);
+    String(int value, unsigned char base = DEC);
+    String(unsigned int value, unsigned char base = DEC);
+    String(long value, unsigned char base = DEC);
+    String(unsigned long value, unsigned char base = DEC);
+
+    String& operator+=(const String& other) { _str += other._str; return *this; }
+    String& operator+=(const char* other) { _str += other; return *this; }
+    String& operator+=(char c) { _str += c; return *this; }
+
+    friend String operator+(const String& a, const String& b)
+    {
+        return String(a._str + b._str);
+    }
+
+    bool operator==(const String& other) const { return _str == other._str; }
+    bool operator!=(const String& other) const { return _str != other._str; }
+    char operator[](unsigned int index) const { return _str[index]; }
+
+    const char* c_str() const { return _str.c_str(); }
+    unsigned int length() const { return _str.length(); }
+
+private:
+    std::string _str;
+};
+
+/* Arduino `Print` */
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    size_t write(const char* buffer, size_t size)
+    {
+        return write((const uint8_t*)buffer, size);
+    }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(const T& value)
+    {
+        size_t n = print(value);
+        return n + println();
+    }
+    template <typename T> size_t println(const T& value, int base)
+    {
+        size_t n = print(value, base);
+        return n + println();
+    }
+};
+
+/* Arduino `Stream` */
+class Stream: public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+/*
+* Serial port over a POSIX file descriptor.
+* - open(path): open a serial device (e.g. /dev/ttyUSB0) or a pty.
+* - attach(fd): use an already opened descriptor (pipe, socket, pty master).
+* begin() sets the baud rate and raw mode of opened terminals. read() never
+* blocks, so the descriptor can be watched with epoll/poll.
+*/
+class HardwareSerial: public Stream
+{
+public:
+    HardwareSerial();
+    explicit HardwareSerial(int fd);
+    ~HardwareSerial();
+
+    bool open(const char* path); //< true on success
+    void attach(int fd); //< The descriptor is not closed by this object
+    void close();
+    int getFd() const { return _fd; }
+
+    void begin(unsigned long baud, uint8_t config = SERIAL_8N1);
+    void end();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite();
+    void flush();
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    operator bool() const { return _fd >= 0; }
+
+private:
+    bool _fill();
+
+    int _fd;
+    bool _isOwner; //< true if the descriptor was opened by open()
+
+    byte _rx[256]; //< Bytes read from the descriptor, not consumed yet
+    uint16_t _rxHead;
+    uint16_t _rxTail;
+};
+
+extern HardwareSerial Serial; //< Standard output
+extern HardwareSerial Serial1; //< Not opened, see `HardwareSerial::open()`
+
+#endif
@@ -0,0 +1,32 @@
+#include "EEPROM.h"
+
+#include <string.h>
+
+EEPROMClass::EEPROMClass(): _numWrites(0)
+{
+    erase();
+}
+
+uint8_t EEPROMClass::read(int address)
+{
+    return _data[address & E2END];
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+    _data[address & E2END] = value;
+    _numWrites++;
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+    if (read(address) != value)
+        write(address, value);
+}
+
+void EEPROMClass::erase()
+{
+    memset(_data, 0xFF, sizeof(_data));
+}
+
+EEPROMClass EEPROM;
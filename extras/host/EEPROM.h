@@ -0,0 +1,36 @@
+/*
+* Host (Linux) implementation of the Arduino `EEPROM` library: the EEPROM of
+* the ATmega32U4 (1 KB, erased to 0xFF) is emulated in RAM, and the number of
+* writes is counted to measure wear.
+*/
+#ifndef _HOST_EEPROM_H_
+#define _HOST_EEPROM_H_
+
+#include "Arduino.h"
+
+#define E2END                        0x3FF
+
+class EEPROMClass
+{
+public:
+    EEPROMClass();
+
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    uint16_t length() { return E2END + 1; }
+
+    /* Host only: number of bytes written since the start */
+    uint32_t getNumWrites() { return _numWrites; }
+
+    /* Host only: erase every byte (0xFF) */
+    void erase();
+
+private:
+    uint8_t _data[E2END + 1];
+    uint32_t _numWrites;
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
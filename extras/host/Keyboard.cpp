@@ -0,0 +1,37 @@
+#include "Keyboard.h"
+
+#include <unistd.h>
+
+Keyboard_::Keyboard_(): _fd(STDOUT_FILENO) {}
+
+size_t Keyboard_::press(uint8_t key)
+{
+    return write(key);
+}
+
+size_t Keyboard_::release(uint8_t key)
+{
+    (void)key;
+    return 1;
+}
+
+size_t Keyboard_::write(uint8_t key)
+{
+    return write(&key, 1);
+}
+
+size_t Keyboard_::write(const uint8_t* buffer, size_t size)
+{
+    if (_fd < 0)
+        return size;
+
+    ssize_t written = ::write(_fd, buffer, size);
+    return (written > 0) ? written : 0;
+}
+
+void Keyboard_::setOutput(int fd)
+{
+    _fd = fd;
+}
+
+Keyboard_ Keyboard;
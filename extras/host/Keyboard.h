@@ -0,0 +1,36 @@
+/*
+* Host (Linux) implementation of the Arduino `Keyboard` library: keystrokes
+* are written to a file descriptor (standard output by default) instead of
+* being sent as USB HID reports.
+*/
+#ifndef _HOST_KEYBOARD_H_
+#define _HOST_KEYBOARD_H_
+
+#include "Arduino.h"
+
+class Keyboard_: public Print
+{
+public:
+    Keyboard_();
+
+    void begin() {}
+    void end() {}
+
+    size_t press(uint8_t key);
+    size_t release(uint8_t key);
+    void releaseAll() {}
+
+    size_t write(uint8_t key) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    /* Host only: write keystrokes to `fd` (-1 discards them) */
+    void setOutput(int fd);
+
+private:
+    int _fd;
+};
+
+extern Keyboard_ Keyboard;
+
+#endif
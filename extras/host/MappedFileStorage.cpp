@@ -0,0 +1,83 @@
+#include "MappedFileStorage.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFileStorage::MappedFileStorage(): _fd(-1), _data(NULL), _size(0) {}
+
+MappedFileStorage::~MappedFileStorage()
+{
+    close();
+}
+
+bool MappedFileStorage::open(const char* path, const size_t size)
+{
+    close();
+
+    _fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(_fd, &info) < 0) {
+        close();
+        return false;
+    }
+
+    size_t oldSize = (size_t)info.st_size;
+    if ((oldSize < size) && (ftruncate(_fd, size) < 0)) {
+        close();
+        return false;
+    }
+
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    _data = (byte*)data;
+    _size = size;
+
+    // New bytes read as 0, make them look erased
+    if (oldSize < size)
+        memset(_data + oldSize, 0xFF, size - oldSize);
+    return true;
+}
+
+void MappedFileStorage::close()
+{
+    if (_data != NULL)
+        munmap(_data, _size);
+    if (_fd >= 0)
+        ::close(_fd);
+
+    _fd = -1;
+    _data = NULL;
+    _size = 0;
+}
+
+size_t MappedFileStorage::getSize()
+{
+    return _size;
+}
+
+void MappedFileStorage::read(const size_t address, byte* data, const size_t size)
+{
+    memcpy(data, _data + address, size);
+}
+
+void MappedFileStorage::write(const size_t address, const byte* data,
+                              const size_t size)
+{
+    memcpy(_data + address, data, size);
+}
+
+void MappedFileStorage::commit()
+{
+    if (_data != NULL)
+        msync(_data, _size, MS_SYNC);
+}
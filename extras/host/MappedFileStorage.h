@@ -0,0 +1,58 @@
+#ifndef _MAPPED_FILE_STORAGE_H_
+#define _MAPPED_FILE_STORAGE_H_
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Storage.h"
+
+/*
+* @brief Storage in a memory-mapped file (host only)
+* @detail The file is mapped with mmap(), read() and write() copy bytes from
+* and to the mapping, commit() waits for the dirty pages to be written
+* (msync()). A new file is filled with 0xFF (like an erased EEPROM).
+*
+* @example
+* ```
+*     MappedFileStorage storage;
+*     if (!storage.open("reader0.db", DatabaseJournal::getMinSize() + 4096))
+*         perror("reader0.db");
+*     DatabaseJournal journal(storage);
+* ```
+*/
+class MappedFileStorage: public Storage
+{
+public:
+    MappedFileStorage();
+    ~MappedFileStorage();
+
+    /**
+    * @brief Open (or create) and map a file
+    * @param
+    * - path: path of the file.
+    * - size: number of bytes, the file is extended if it is shorter.
+    * @return true if the file is mapped, false otherwise (see `errno`)
+    */
+    bool open(const char* path, const size_t size);
+
+    /* Unmap and close the file */
+    void close();
+
+    size_t getSize() override;
+    void read(const size_t address, byte* data, const size_t size) override;
+    void write(const size_t address, const byte* data,
+               const size_t size) override;
+    void commit() override;
+
+private:
+    MappedFileStorage(const MappedFileStorage&);
+    MappedFileStorage& operator=(const MappedFileStorage&);
+
+    int _fd;
+    byte* _data;
+    size_t _size;
+};
+
+#endif
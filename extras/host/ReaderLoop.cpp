@@ -0,0 +1,164 @@
+#include "ReaderLoop.h"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+/* Constructor */
+ReaderLoop::ReaderLoop()
+{
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    _numReaders = 0;
+    _isRunning = false;
+
+    _callback = NULL;
+    _context = NULL;
+}
+
+ReaderLoop::~ReaderLoop()
+{
+    if (_epollFd >= 0)
+        close(_epollFd);
+}
+
+/**
+* @public
+* @brief Add a reader to the loop
+*/
+Status ReaderLoop::addReader(InventorySession& session, HardwareSerial& serial,
+                             const byte* request, size_t size, const uint32_t period)
+{
+    if (_numReaders >= READER_LOOP_MAX_READERS)
+        return ERR_QUEUE_FULL;
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u32 = _numReaders;
+    if (_epollFd < 0 || epoll_ctl(_epollFd, EPOLL_CTL_ADD, serial.getFd(), &event) != 0)
+        return ERR_READ_RS485;
+
+    Reader& reader = _readers[_numReaders++];
+    reader.session = &session;
+    reader.serial = &serial;
+    reader.request = request;
+    reader.size = size;
+    reader.period = period;
+    reader.lastStart = 0;
+    reader.isStarted = false;
+    reader.isOnline = true;
+
+    return STATUS_SUCCESS;
+}
+
+/* Set the function called when an inventory session is finished */
+void ReaderLoop::setCallback(SessionCallback callback, void* context)
+{
+    _callback = callback;
+    _context = context;
+}
+
+/**
+* @public
+* @brief Run one iteration of the loop
+*/
+void ReaderLoop::runOnce(const int timeout)
+{
+    int wait = _startDue(millis());
+
+    // Busy sessions are polled every tick for the end of the request on the
+    // wire and for time-outs, bytes wake the loop up earlier
+    for (byte i = 0; i < _numReaders; i++) {
+        if (_readers[i].session->isBusy()) {
+            if (wait < 0 || wait > READER_LOOP_TICK)
+                wait = READER_LOOP_TICK;
+            break;
+        }
+    }
+
+    if (timeout >= 0 && (wait < 0 || wait > timeout))
+        wait = timeout;
+
+    struct epoll_event events[READER_LOOP_MAX_READERS];
+    int numEvents = epoll_wait(_epollFd, events, READER_LOOP_MAX_READERS, wait);
+
+    for (int n = 0; n < numEvents; n++) {
+        byte i = events[n].data.u32;
+        Reader& reader = _readers[i];
+
+        // Stop watching a serial port which hangs up (e.g. unplugged adapter)
+        if ((events[n].events & (EPOLLHUP | EPOLLERR))
+            && !(events[n].events & EPOLLIN)) {
+            epoll_ctl(_epollFd, EPOLL_CTL_DEL, reader.serial->getFd(), NULL);
+            reader.isOnline = false;
+            if (_callback)
+                _callback(i, ERR_READ_RS485, _context);
+        }
+    }
+
+    for (byte i = 0; i < _numReaders; i++)
+        _poll(i);
+}
+
+/* Run the loop until stop() is called */
+void ReaderLoop::run()
+{
+    _isRunning = true;
+    while (_isRunning)
+        runOnce(-1);
+}
+
+/* Make run() return */
+void ReaderLoop::stop()
+{
+    _isRunning = false;
+}
+
+/* Get number of readers */
+byte ReaderLoop::getNumReaders()
+{
+    return _numReaders;
+}
+
+/**
+* @private
+* @brief Start the due inventory commands
+* @return time (ms) to the next inventory command, -1 if there is none
+*/
+int ReaderLoop::_startDue(const uint32_t now)
+{
+    int wait = -1;
+
+    for (byte i = 0; i < _numReaders; i++) {
+        Reader& reader = _readers[i];
+        if (!reader.isOnline || reader.session->isBusy())
+            continue;
+
+        uint32_t elapsed = now - reader.lastStart;
+        if (!reader.isStarted || elapsed >= reader.period) {
+            reader.session->start(reader.request, reader.size);
+            reader.isStarted = true;
+            reader.lastStart = now;
+            elapsed = 0;
+        }
+
+        int remaining = reader.period - elapsed;
+        if (wait < 0 || remaining < wait)
+            wait = remaining;
+    }
+
+    return wait;
+}
+
+/**
+* @private
+* @brief Advance the session of a reader
+*/
+void ReaderLoop::_poll(const byte i)
+{
+    InventorySession* session = _readers[i].session;
+    if (!session->isBusy())
+        return;
+
+    Status status = session->poll();
+    if (status != STATUS_RS485_BUSY && _callback)
+        _callback(i, status, _context);
+}
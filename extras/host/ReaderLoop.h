@@ -0,0 +1,120 @@
+#ifndef _READER_LOOP_H_
+#define _READER_LOOP_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+#include "InventorySession.h"
+
+// Maximum number of readers driven by one `ReaderLoop`
+#ifndef READER_LOOP_MAX_READERS
+#define READER_LOOP_MAX_READERS      64
+#endif
+
+// Time (ms) between 2 polls of the busy sessions when no byte arrives, i.e.
+// the resolution of the response time-outs (see `DEFAULT_RX_TIMEOUT`)
+#define READER_LOOP_TICK             10
+
+/*
+* @brief Event loop of many readers (host only)
+* @detail One thread drives every reader of a site: each reader has its own
+* serial port (`HardwareSerial` over a file descriptor), `UHFRecv`,
+* `Database` and `InventorySession`. The loop sleeps in epoll_wait() until
+* a serial port has bytes to read, a session times out or an inventory
+* command is due, so idle readers cost nothing.
+*
+* @example
+* ```
+*     ReaderLoop loop;
+*     loop.setCallback(onSession, NULL);
+*     loop.addReader(session, serial, cmd, sizeCmd, 600);
+*     loop.run(); //< until stop()
+* ```
+*/
+class ReaderLoop
+{
+public:
+    /**
+    * Called when an inventory session of a reader is finished.
+    * - reader: index of the reader (order of addReader()).
+    * - status: return value of `InventorySession::poll()`.
+    * - context: pointer given to setCallback().
+    */
+    typedef void (*SessionCallback)(byte reader, Status status, void* context);
+
+    ReaderLoop();
+    ~ReaderLoop();
+
+    /**
+    * @brief Add a reader to the loop
+    *
+    * @param
+    * - session: inventory session of the reader.
+    * - serial: serial port of the reader (opened and begun).
+    * - request: inventory command, sent every `period` ms (the array must
+    *   outlive the loop).
+    * - size: size of request array.
+    * - period: time (ms) between 2 inventory commands.
+    *
+    * @return
+    * - STATUS_SUCCESS: the reader is added.
+    * - ERR_QUEUE_FULL: there are already `READER_LOOP_MAX_READERS` readers.
+    * - ERR_READ_RS485: the serial port can not be watched.
+    */
+    Status addReader(InventorySession& session, HardwareSerial& serial,
+                     const byte* request, size_t size, const uint32_t period);
+
+    /* Set the function called when an inventory session is finished */
+    void setCallback(SessionCallback callback, void* context);
+
+    /**
+    * @brief Run one iteration of the loop
+    * @detail Start the due inventory commands, wait for bytes (at most
+    * `timeout` ms) and advance the sessions.
+    *
+    * @param
+    * - timeout: maximum time (ms) to wait, -1 to wait for the next event.
+    *
+    * @return none
+    */
+    void runOnce(const int timeout);
+
+    /* Run the loop until stop() is called (e.g. from the callback) */
+    void run();
+
+    /* Make run() return */
+    void stop();
+
+    /* Get number of readers */
+    byte getNumReaders();
+
+private:
+    typedef struct {
+        InventorySession* session;
+        HardwareSerial* serial;
+        const byte* request;
+        size_t size;
+        uint32_t period;
+        uint32_t lastStart; //< millis() of the last inventory command
+        bool isStarted; //< false until the first inventory command
+        bool isOnline; //< false after the serial port hangs up
+    } Reader;
+
+    /* Start the due inventory commands, return the time (ms) to the next one */
+    int _startDue(const uint32_t now);
+
+    /* Advance the session of a reader */
+    void _poll(const byte reader);
+
+    int _epollFd;
+    Reader _readers[READER_LOOP_MAX_READERS];
+    byte _numReaders;
+    bool _isRunning;
+
+    SessionCallback _callback;
+    void* _context;
+};
+
+#endif
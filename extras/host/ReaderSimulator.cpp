@@ -0,0 +1,343 @@
+#include "ReaderSimulator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Crc16.h"
+
+/* Constructor */
+ReaderSimulator::ReaderSimulator(const uint32_t seed, const byte address)
+{
+    _seed = (seed != 0) ? seed : 1; //< xorshift32 must not start from 0
+    _salt = (uint64_t)seed << 32;
+    _address = address;
+    _fd = -1;
+    _isOwner = false;
+    _slaveFd = -1;
+    _ptyName[0] = '\0';
+
+    _numTags = 0;
+    _nextSerial = 0;
+
+    _arrivals = 0;
+    _departure = 0;
+    _noCard = 0;
+    _crcError = 0;
+    _corruption = 0;
+    _delay = 0;
+    _byteTime = 0;
+    _tagsPerFrame = MAX_CARDS;
+
+    _requestSize = 0;
+    _outSize = 0;
+    _outSent = 0;
+    _outStart = 0;
+
+    _numRequests = 0;
+    _numFrames = 0;
+}
+
+ReaderSimulator::~ReaderSimulator()
+{
+    if (_isOwner && _fd >= 0)
+        close(_fd);
+    if (_slaveFd >= 0)
+        close(_slaveFd);
+}
+
+/**
+* @public
+* @brief Open a pty, the simulator is the master side
+*/
+Status ReaderSimulator::openPty()
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return STATUS_ERROR;
+
+    if (grantpt(fd) != 0 || unlockpt(fd) != 0 || ptsname(fd) == NULL) {
+        close(fd);
+        return STATUS_ERROR;
+    }
+    snprintf(_ptyName, sizeof(_ptyName), "%s", ptsname(fd));
+
+    // Keep the slave side open, so the master does not hang up while no
+    // client has opened it yet (or between 2 clients)
+    _slaveFd = open(_ptyName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+    // Raw bytes in both directions (termios are shared with the slave side)
+    struct termios tty;
+    if (tcgetattr(fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+
+    attach(fd);
+    _isOwner = true;
+    return STATUS_SUCCESS;
+}
+
+/* Get the path of the slave side of the pty */
+const char* ReaderSimulator::getPtyName()
+{
+    return _ptyName;
+}
+
+/* Use an opened descriptor, not closed by the simulator */
+void ReaderSimulator::attach(int fd)
+{
+    _fd = fd;
+    _isOwner = false;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/* Get the descriptor of the simulator's side */
+int ReaderSimulator::getFd()
+{
+    return _fd;
+}
+
+/* Set the tags in the field */
+void ReaderSimulator::setPopulation(const uint16_t numTags)
+{
+    _numTags = 0;
+    while (_numTags < numTags && _numTags < SIM_MAX_TAGS)
+        _arrive();
+}
+
+/* Set the churn of the tags */
+void ReaderSimulator::setChurn(const float arrivals, const float departure)
+{
+    _arrivals = arrivals;
+    _departure = departure;
+}
+
+/* Set the rates of faults */
+void ReaderSimulator::setFaults(const float noCard, const float crcError,
+                                const float corruption)
+{
+    _noCard = noCard;
+    _crcError = crcError;
+    _corruption = corruption;
+}
+
+/* Set the timing of the responses */
+void ReaderSimulator::setLatency(const uint32_t delay, const long baudRate)
+{
+    _delay = delay;
+    _byteTime = (baudRate > 0) ? (10000000UL / baudRate) : 0; //< 8N1: 10 bits
+}
+
+/* Set the maximum number of tags per frame */
+void ReaderSimulator::setTagsPerFrame(const byte tagsPerFrame)
+{
+    _tagsPerFrame = (tagsPerFrame > 0) ? tagsPerFrame : 1;
+}
+
+/**
+* @public
+* @brief Serve the requests (non-blocking)
+*/
+void ReaderSimulator::poll()
+{
+    if (_fd < 0)
+        return;
+
+    byte buffer[64];
+    ssize_t n;
+    while ((n = read(_fd, buffer, sizeof(buffer))) > 0) {
+        // Half duplex: requests are not heard while a response is sent
+        if (_outSent < _outSize)
+            continue;
+
+        for (ssize_t i = 0; i < n; i++) {
+            _request[_requestSize++] = buffer[i];
+
+            // Skip bytes which can not start a request (Len, Adr, Cmd, CRC)
+            byte len = _request[RE_LENGTH_INDEX];
+            if (len < 4 || len > sizeof(_request) - 1) {
+                _requestSize = 0;
+                continue;
+            }
+            if (_requestSize < len + 1)
+                continue;
+
+            _requestSize = 0;
+            if (crc16Update(CRC16_INIT, _request, len + 1) != 0)
+                continue; //< A real reader ignores corrupted requests
+            if (_request[RE_ADDRESS_INDEX] != _address
+                && _request[RE_ADDRESS_INDEX] != 0xFF)
+                continue;
+
+            _outStart = micros() + _delay;
+            if (_request[RE_COMMAND_INDEX] == 0x01 && len == 6)
+                _inventory(_request[4]);
+            else
+                _queueFrame(0x00, STATUS_ERROR, NULL, 0); //< Unrecognised
+        }
+    }
+
+    // Write the due bytes
+    uint32_t now = micros();
+    int32_t elapsed = (int32_t)(now - _outStart);
+    if (_outSent >= _outSize || elapsed < 0)
+        return;
+
+    size_t due = _outSize;
+    if (_byteTime > 0 && (size_t)(elapsed / _byteTime) + 1 < due)
+        due = elapsed / _byteTime + 1;
+
+    while (_outSent < due) {
+        n = write(_fd, _out + _outSent, due - _outSent);
+        if (n <= 0)
+            break; //< Retry on the next poll()
+        _outSent += n;
+    }
+
+    if (_outSent == _outSize) {
+        _outSent = 0;
+        _outSize = 0;
+    }
+}
+
+/* Time (ms, rounded up) to the next due byte */
+int ReaderSimulator::getWait()
+{
+    if (_outSent >= _outSize)
+        return -1;
+
+    uint32_t due = _outStart + _outSent * _byteTime;
+    int32_t wait = (int32_t)(due - micros());
+    return (wait <= 0) ? 0 : (wait + 999) / 1000;
+}
+
+/* Get number of tags in the field */
+uint16_t ReaderSimulator::getNumTags()
+{
+    return _numTags;
+}
+
+/* Get number of inventory commands answered */
+uint32_t ReaderSimulator::getNumRequests()
+{
+    return _numRequests;
+}
+
+/* Get number of response frames queued */
+uint32_t ReaderSimulator::getNumFrames()
+{
+    return _numFrames;
+}
+
+/**
+* @private
+* @brief Inventory: apply the churn and queue the response frames
+*/
+void ReaderSimulator::_inventory(const byte lenTid)
+{
+    _numRequests++;
+
+    // Departures, then arrivals
+    for (uint16_t i = 0; i < _numTags; ) {
+        if (_random() < _departure)
+            _tags[i] = _tags[--_numTags];
+        else
+            i++;
+    }
+    uint16_t arrivals = (uint16_t)_arrivals;
+    if (_random() < _arrivals - arrivals)
+        arrivals++;
+    while (arrivals-- > 0 && _numTags < SIM_MAX_TAGS)
+        _arrive();
+
+    float fault = _random();
+    if (_numTags == 0 || fault < _noCard) {
+        _queueFrame(0x01, ERR_INV_NO_CARD, NULL, 0);
+        return;
+    }
+    if (fault < _noCard + _crcError) {
+        _queueFrame(0x01, ERR_CRC, NULL, 0);
+        return;
+    }
+
+    // TID size is requested in words, a frame must fit in 255 bytes (Len)
+    const byte tidSize = lenTid * 2;
+    byte tagsPerFrame = _tagsPerFrame;
+    if (tagsPerFrame > (255 - 6) / (tidSize + 1))
+        tagsPerFrame = (255 - 6) / (tidSize + 1);
+
+    byte data[256];
+    for (uint16_t first = 0; first < _numTags; first += tagsPerFrame) {
+        byte num = (_numTags - first < tagsPerFrame) ? _numTags - first : tagsPerFrame;
+        size_t size = 0;
+
+        data[size++] = num;
+        for (byte i = 0; i < num; i++) {
+            // TID bytes are derived from the serial number of the tag
+            uint64_t x = (_salt | _tags[first + i]) * 0x9E3779B97F4A7C15ULL;
+            data[size++] = tidSize;
+            for (byte j = 0; j < tidSize; j++) {
+                x ^= x >> 29;
+                x *= 0xBF58476D1CE4E5B9ULL;
+                data[size++] = (byte)(x >> 56);
+            }
+        }
+
+        bool isLast = (first + num >= _numTags);
+        _queueFrame(0x01, isLast ? STATUS_SUCCESS : ERR_INV_FRAME_OUT, data, size);
+    }
+}
+
+/**
+* @private
+* @brief Queue a response frame, the CRC is appended
+*/
+void ReaderSimulator::_queueFrame(const byte reCmd, const byte status,
+                                  const byte* data, const size_t size)
+{
+    size_t frameSize = RE_DATA_INDEX + size + 2;
+    if (_outSize + frameSize > SIM_OUTPUT_SIZE)
+        return;
+
+    byte* frame = _out + _outSize;
+    frame[RE_LENGTH_INDEX] = frameSize - 1;
+    frame[RE_ADDRESS_INDEX] = _address;
+    frame[RE_COMMAND_INDEX] = reCmd;
+    frame[RE_STATUS_INDEX] = status;
+    if (size > 0)
+        memcpy(frame + RE_DATA_INDEX, data, size);
+
+    // CRC-16: LSB first
+    uint16_t crc = crc16Update(CRC16_INIT, frame, frameSize - 2);
+    frame[frameSize - 2] = lowByte(crc);
+    frame[frameSize - 1] = highByte(crc);
+
+    if (_corruption > 0) {
+        for (size_t i = 0; i < frameSize; i++) {
+            if (_random() < _corruption)
+                frame[i] ^= 1 << (byte)(_random() * 8);
+        }
+    }
+
+    _outSize += frameSize;
+    _numFrames++;
+}
+
+/* Random number in [0, 1) (xorshift32) */
+float ReaderSimulator::_random()
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return (_seed >> 8) / 16777216.0f;
+}
+
+/* Add a new tag to the field */
+void ReaderSimulator::_arrive()
+{
+    _tags[_numTags++] = _nextSerial++;
+}
@@ -0,0 +1,189 @@
+#ifndef _READER_SIMULATOR_H_
+#define _READER_SIMULATOR_H_
+
+#include <Arduino.h>
+
+#include <stdint.h>
+
+#include "attribute.h"
+
+// Maximum number of tags in the field of a simulated reader
+#ifndef SIM_MAX_TAGS
+#define SIM_MAX_TAGS                 1024
+#endif
+
+// Size (bytes) of the output buffer of a simulated reader
+#define SIM_OUTPUT_SIZE              16384
+
+/*
+* @brief Software PK-UHF101U reader (host only)
+* @detail Answers the inventory command built by `UHFRecv::setCommand()` with
+* well-formed response frames (see `attribute.h`), so `UHFRecv`,
+* `InventorySession` and `Database` can be exercised without hardware:
+* - Tags: a population of tags in the field, with arrivals and departures
+*   between 2 inventory commands. TIDs are `lenTid` words long, as requested.
+* - Frames: up to `tagsPerFrame` tags per frame, all frames but the last one
+*   have status `ERR_INV_FRAME_OUT`. An empty field is `ERR_INV_NO_CARD`.
+* - Faults: `ERR_INV_NO_CARD` or `ERR_CRC` responses at a given rate, random
+*   bit flips of the bytes on the wire.
+* - Timing: a delay before the first byte (inventory time) and the time of
+*   each byte on the wire at a given baud rate.
+*
+* The simulator talks over a file descriptor: the master of a pty (give the
+* slave to `HardwareSerial::open()`), or one end of a socketpair (give the
+* other end to `HardwareSerial::attach()`). Random numbers come from a seeded
+* generator, so a run is reproducible.
+*
+* @example
+* ```
+*     ReaderSimulator sim(1);
+*     sim.setPopulation(15);
+*     sim.openPty();
+*     serial.open(sim.getPtyName());
+*     ...
+*     sim.poll(); //< Every iteration of the loop
+* ```
+*/
+class ReaderSimulator
+{
+public:
+    /**
+    * @brief Constructor
+    * @param
+    * - seed: seed of the random numbers (tags, churn and faults).
+    * - address: reader address (answers this address and 0xFF).
+    */
+    ReaderSimulator(const uint32_t seed, const byte address = READER_ADDRESS);
+    ~ReaderSimulator();
+
+    /**
+    * @brief Open a pty, the simulator is the master side
+    * @return
+    * - STATUS_SUCCESS: the pty is opened, see getPtyName().
+    * - STATUS_ERROR: no pty available.
+    */
+    Status openPty();
+
+    /* Get the path of the slave side of the pty */
+    const char* getPtyName();
+
+    /* Use an opened descriptor (e.g. socketpair), not closed by the simulator */
+    void attach(int fd);
+
+    /* Get the descriptor of the simulator's side */
+    int getFd();
+
+    /**
+    * @brief Set the tags in the field
+    * @param
+    * - numTags: number of tags in the field (up to `SIM_MAX_TAGS`).
+    * @return none
+    */
+    void setPopulation(const uint16_t numTags);
+
+    /**
+    * @brief Set the churn of the tags, applied before each inventory command
+    * @param
+    * - arrivals: average number of new tags.
+    * - departure: probability of each tag to leave the field.
+    * @return none
+    */
+    void setChurn(const float arrivals, const float departure);
+
+    /**
+    * @brief Set the rates of faults
+    * @param
+    * - noCard: probability of answering `ERR_INV_NO_CARD` (tags are missed).
+    * - crcError: probability of answering `ERR_CRC`.
+    * - corruption: probability of a bit flip in each byte on the wire.
+    * @return none
+    */
+    void setFaults(const float noCard, const float crcError, const float corruption);
+
+    /**
+    * @brief Set the timing of the responses
+    * @param
+    * - delay: time (us) from the request to the first byte of the response.
+    * - baudRate: baud rate of the bytes on the wire (8N1), 0 to send the
+    *   whole response at once.
+    * @return none
+    */
+    void setLatency(const uint32_t delay, const long baudRate);
+
+    /* Set the maximum number of tags per frame (default: `MAX_CARDS`) */
+    void setTagsPerFrame(const byte tagsPerFrame);
+
+    /**
+    * @brief Serve the requests (non-blocking)
+    * @detail Read the requests and write the bytes of the responses which are
+    * due. Call this function often, or when getWait() elapses.
+    * @param none
+    * @return none
+    */
+    void poll();
+
+    /* Time (ms, rounded up) to the next due byte, -1 if there is none */
+    int getWait();
+
+    /* Get number of tags in the field */
+    uint16_t getNumTags();
+
+    /* Get number of inventory commands answered */
+    uint32_t getNumRequests();
+
+    /* Get number of response frames queued */
+    uint32_t getNumFrames();
+
+private:
+    /* Inventory: apply the churn and queue the response frames */
+    void _inventory(const byte lenTid);
+
+    /* Queue a response frame, the CRC is appended */
+    void _queueFrame(const byte reCmd, const byte status, const byte* data,
+                     const size_t size);
+
+    /* Random number in [0, 1) */
+    float _random();
+
+    /* Add a new tag to the field */
+    void _arrive();
+
+    uint32_t _seed; //< xorshift32 state
+    uint64_t _salt; //< TIDs of simulators with different seeds differ
+    byte _address;
+    int _fd;
+    bool _isOwner;
+    int _slaveFd; //< Slave side of the pty, kept open
+    char _ptyName[64];
+
+    // Tags in the field (serial numbers, TIDs are derived from them)
+    uint32_t _tags[SIM_MAX_TAGS];
+    uint16_t _numTags;
+    uint32_t _nextSerial;
+
+    // Config
+    float _arrivals;
+    float _departure;
+    float _noCard;
+    float _crcError;
+    float _corruption;
+    uint32_t _delay;
+    uint32_t _byteTime; //< Time (us) of a byte on the wire, 0 if none
+    byte _tagsPerFrame;
+
+    // Request
+    byte _request[32];
+    byte _requestSize;
+
+    // Response bytes, byte i is due at _outStart + i * _byteTime
+    byte _out[SIM_OUTPUT_SIZE];
+    size_t _outSize;
+    size_t _outSent;
+    uint32_t _outStart; //< micros()
+
+    // Counters
+    uint32_t _numRequests;
+    uint32_t _numFrames;
+};
+
+#endif
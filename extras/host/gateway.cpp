@@ -0,0 +1,169 @@
+/*
+* uhf_gateway: serve every PK-UHF101 reader of a site from one process.
+*
+* Usage: uhf_gateway [-b baud] [-p period] [-s prefix] device...
+* - device: serial port of a reader (e.g. /dev/ttyUSB0, or a pty for tests).
+* - baud: baud rate of the readers (default: 57600).
+* - period: time (ms) between 2 inventory commands (default: 600).
+* - prefix: keep the printed cards of reader N in the file `<prefix>.N` (see
+*   `DatabaseJournal.h`), so they are not printed again after a restart.
+*
+* Each line of the output is `<reader> <event> <TID>`, e.g. `0 in 226000017`
+* when a card arrives and `0 out 226000017` when it has left (see
+* `Database::setEventCallback()`).
+* Built with `-DUHF_INSTRUMENT=ON`, SIGUSR1 dumps the per-stage histograms
+* (see `Instrument.h`) to the standard error.
+*/
+#include <Arduino.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+
+#include "Database.h"
+#include "DatabaseJournal.h"
+#include "Instrument.h"
+#include "InventorySession.h"
+#include "MappedFileStorage.h"
+#include "TextBuffer.h"
+#include "ReaderLoop.h"
+#include "UHFRecv.h"
+
+static ReaderLoop readerLoop;
+static volatile sig_atomic_t isDumpRequested = 0;
+
+typedef struct {
+    byte reader;
+    HardwareSerial serial;
+    UHFRecv* uhf;
+    Database database;
+    InventorySession* session;
+    MappedFileStorage storage;
+    DatabaseJournal* journal;
+} Site;
+
+static void onSignal(int signal)
+{
+    (void)signal;
+    readerLoop.stop();
+}
+
+static void onDumpSignal(int signal)
+{
+    (void)signal;
+    isDumpRequested = 1;
+}
+
+/* Print a card which has just arrived at a reader, or left it */
+static void onCard(const CardEvent& event, void* context)
+{
+    Site* site = (Site*)context;
+    if (event.type == CARD_REFRESHED)
+        return;
+
+    if (event.type == CARD_ARRIVED)
+        site->database.markPrinted(site->database.getDB().getQueueData()[event.slot]);
+
+    char tid[3 * MAX_SIZE_TID + 1];
+    TextBuffer text(tid, sizeof(tid));
+    printTid(text, event.key);
+    printf("%u %s %s\n", site->reader, (event.type == CARD_ARRIVED) ? "in" : "out",
+           text.c_str());
+}
+
+/* Report the errors of a reader, write the output and the journal */
+static void onSession(byte reader, Status status, void* context)
+{
+    Site* site = (Site*)context + reader;
+
+    if (isDumpRequested) {
+        isDumpRequested = 0;
+        HardwareSerial err(STDERR_FILENO);
+        instrumentDump(err);
+    }
+
+    if (status == ERR_READ_RS485) {
+        fprintf(stderr, "%u: serial port hung up\n", reader);
+        return;
+    }
+    if (status != STATUS_SUCCESS && status != ERR_INV_NO_CARD)
+        fprintf(stderr, "%u: error 0x%02X\n", reader, status);
+
+    // Cards also leave while the field is empty
+    site->database.sweepExpired(millis());
+    fflush(stdout);
+
+    site->database.sync(millis());
+}
+
+int main(int argc, char* argv[])
+{
+    long baudRate = DEFAULT_BAUD_RATE;
+    uint32_t period = 600;
+    const char* prefix = NULL;
+
+    int option;
+    while ((option = getopt(argc, argv, "b:p:s:")) != -1) {
+        if (option == 'b')
+            baudRate = atol(optarg);
+        else if (option == 'p')
+            period = atol(optarg);
+        else if (option == 's')
+            prefix = optarg;
+        else
+            break;
+    }
+
+    int numReaders = argc - optind;
+    if (numReaders <= 0 || numReaders > READER_LOOP_MAX_READERS) {
+        fprintf(stderr, "Usage: %s [-b baud] [-p period] [-s prefix] device...\n",
+                argv[0]);
+        return 1;
+    }
+
+    Site* sites = new Site[numReaders];
+    for (int i = 0; i < numReaders; i++) {
+        Site& site = sites[i];
+        const char* path = argv[optind + i];
+        if (!site.serial.open(path)) {
+            perror(path);
+            return 1;
+        }
+
+        site.uhf = new UHFRecv(site.serial, baudRate, DEFAULT_RS485_CTL_PIN);
+        site.uhf->begin();
+        site.database.begin();
+
+        if (prefix != NULL) {
+            // The journal is as large as the 2 snapshots
+            std::string file = std::string(prefix) + "." + std::to_string(i);
+            if (!site.storage.open(file.c_str(), 4 * DatabaseJournal::getSlotSize())) {
+                perror(file.c_str());
+                return 1;
+            }
+            site.journal = new DatabaseJournal(site.storage);
+            site.database.restore(*site.journal);
+        }
+        site.reader = i;
+        site.database.setEventCallback(onCard, &site);
+        site.session = new InventorySession(*site.uhf, site.database);
+
+        byte* cmd = site.uhf->setCommand(READER_ADDRESS, TID_ARRESSS, LENGTH_TID);
+        readerLoop.addReader(*site.session, site.serial, cmd,
+                             site.uhf->getSizeCommand(), period);
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGUSR1, onDumpSignal);
+
+    readerLoop.setCallback(onSession, sites);
+    readerLoop.run();
+
+    // Keep the changes still batched in RAM
+    for (int i = 0; (prefix != NULL) && (i < numReaders); i++)
+        sites[i].database.checkpoint();
+
+    return 0;
+}
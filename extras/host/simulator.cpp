@@ -0,0 +1,351 @@
+/*
+* uhf_simulator: software PK-UHF101U readers (see `ReaderSimulator.h`).
+*
+* Usage:
+*   uhf_simulator [options] N    serve N readers over ptys, the slave paths
+*                                are printed one per line (e.g. for
+*                                `uhf_gateway`), until Ctrl-C.
+*   uhf_simulator -m [options]   measure throughput and latency of
+*                                `InventorySession` + `Database` in process
+*                                (socketpair) at 1, 15 and 500 tags.
+*   uhf_simulator -m -r N        measure the sweeps of `BusScheduler` over
+*                                N readers (addresses 0 to N-1) sharing one
+*                                serial port.
+*
+* Options:
+*   -t tags       tags in the field (-m: measure this population only)
+*   -a arrivals   average number of new tags per inventory command
+*   -d departure  probability of each tag to leave per inventory command
+*   -x noCard     probability of an ERR_INV_NO_CARD response
+*   -e crcError   probability of an ERR_CRC response
+*   -c corrupt    probability of a bit flip per byte on the wire
+*   -l delay      time (us) from the request to the first byte
+*   -b baud       baud rate on the wire, 0 for no wire time (default: 0)
+*   -f tags       maximum number of tags per frame (default: MAX_CARDS)
+*   -s seed       seed of the random numbers (default: 1)
+*   -n sessions   -m: number of inventory sessions (sweeps with -r) per
+*                 population
+*   -r readers    -m: readers on one bus, see `BusScheduler.h`
+*/
+#include <Arduino.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "BusScheduler.h"
+#include "Database.h"
+#include "InventorySession.h"
+#include "ReaderSimulator.h"
+#include "UHFRecv.h"
+
+typedef struct {
+    long tags;
+    float arrivals;
+    float departure;
+    float noCard;
+    float crcError;
+    float corruption;
+    uint32_t delay;
+    long baudRate;
+    byte tagsPerFrame;
+    uint32_t seed;
+    uint32_t numSessions;
+    int numReaders;
+} Options;
+
+static volatile bool isRunning = true;
+
+static void onSignal(int signal)
+{
+    (void)signal;
+    isRunning = false;
+}
+
+static void configure(ReaderSimulator& sim, const Options& options, long tags)
+{
+    sim.setPopulation(tags);
+    sim.setChurn(options.arrivals, options.departure);
+    sim.setFaults(options.noCard, options.crcError, options.corruption);
+    sim.setLatency(options.delay, options.baudRate);
+    sim.setTagsPerFrame(options.tagsPerFrame);
+}
+
+/* Serve readers over ptys */
+static int serve(const Options& options, int numReaders)
+{
+    ReaderSimulator** sims = new ReaderSimulator*[numReaders];
+    struct pollfd* fds = new struct pollfd[numReaders];
+
+    for (int i = 0; i < numReaders; i++) {
+        sims[i] = new ReaderSimulator(options.seed + i);
+        configure(*sims[i], options, (options.tags >= 0) ? options.tags : 15);
+        if (sims[i]->openPty() != STATUS_SUCCESS) {
+            perror("openpty");
+            return 1;
+        }
+        fds[i].fd = sims[i]->getFd();
+        fds[i].events = POLLIN;
+        printf("%s\n", sims[i]->getPtyName());
+    }
+    fflush(stdout);
+
+    while (isRunning) {
+        int wait = 100;
+        for (int i = 0; i < numReaders; i++) {
+            int simWait = sims[i]->getWait();
+            if (simWait >= 0 && simWait < wait)
+                wait = simWait;
+        }
+
+        poll(fds, numReaders, wait);
+        for (int i = 0; i < numReaders; i++)
+            sims[i]->poll();
+    }
+
+    for (int i = 0; i < numReaders; i++) {
+        fprintf(stderr, "%s: %u requests, %u frames, %u tags\n",
+                sims[i]->getPtyName(), sims[i]->getNumRequests(),
+                sims[i]->getNumFrames(), sims[i]->getNumTags());
+        delete sims[i];
+    }
+    return 0;
+}
+
+/* Measure inventory sessions at one tag population */
+static void measure(const Options& options, long tags)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        perror("socketpair");
+        return;
+    }
+
+    ReaderSimulator sim(options.seed);
+    configure(sim, options, tags);
+    sim.attach(sv[1]);
+
+    // Without wire time, the request leaves the wire at once
+    HardwareSerial serial(sv[0]);
+    UHFRecv uhf(serial, (options.baudRate > 0) ? options.baudRate : 10000000L,
+                DEFAULT_RS485_CTL_PIN);
+    uhf.begin();
+    Database* database = new Database;
+    database->begin();
+    InventorySession session(uhf, *database);
+
+    byte* cmd = uhf.setCommand(READER_ADDRESS, TID_ARRESSS, LENGTH_TID);
+    size_t sizeCmd = uhf.getSizeCommand();
+
+    uint32_t* latencies = new uint32_t[options.numSessions];
+    uint32_t numStatus[256] = {0};
+    uint32_t numFrames = 0;
+
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < options.numSessions; i++) {
+        uint32_t t0 = micros();
+        Status status = session.start(cmd, sizeCmd);
+        while (status == STATUS_SUCCESS || status == STATUS_RS485_BUSY) {
+            sim.poll();
+            status = session.poll();
+            if (status != STATUS_RS485_BUSY)
+                break;
+        }
+        latencies[i] = micros() - t0;
+        numStatus[status]++;
+        numFrames += session.getNumFrames();
+    }
+    uint32_t elapsed = micros() - start;
+
+    std::sort(latencies, latencies + options.numSessions);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < options.numSessions; i++)
+        sum += latencies[i];
+
+    printf("%5ld %8u %8u %8u %9.1f %9u %9u %9u %10.1f",
+           tags, options.numSessions, numFrames, (unsigned)database->getDB().getSize(),
+           (double)sum / options.numSessions,
+           latencies[options.numSessions / 2],
+           latencies[options.numSessions * 99 / 100],
+           latencies[options.numSessions - 1],
+           options.numSessions * 1e6 / (elapsed ? elapsed : 1));
+    for (int s = 0; s < 256; s++) {
+        if (numStatus[s] > 0)
+            printf("  0x%02X:%u", s, numStatus[s]);
+    }
+    printf("\n");
+
+    delete[] latencies;
+    delete database;
+    close(sv[0]);
+    close(sv[1]);
+}
+
+/* Copy the bytes available on `from` to every descriptor of `to` */
+static void relay(int from, const int* to, int numTo)
+{
+    byte buffer[256];
+    ssize_t n;
+    while ((n = recv(from, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+        for (int i = 0; i < numTo; i++) {
+            if (write(to[i], buffer, n) != n)
+                perror("write");
+        }
+    }
+}
+
+/* Measure sweeps of several readers on one bus at one tag population */
+static void measureBus(const Options& options, long tags)
+{
+    int numReaders = options.numReaders;
+
+    // The bus: the host side and one socketpair per reader, relayed both ways
+    int host[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, host) != 0) {
+        perror("socketpair");
+        return;
+    }
+    int* bus = new int[numReaders]; //< Relay side of each reader
+    ReaderSimulator** sims = new ReaderSimulator*[numReaders];
+    for (int i = 0; i < numReaders; i++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+            perror("socketpair");
+            return;
+        }
+        bus[i] = sv[0];
+        sims[i] = new ReaderSimulator(options.seed + i, (byte)i);
+        configure(*sims[i], options, tags);
+        sims[i]->attach(sv[1]);
+    }
+
+    HardwareSerial serial(host[0]);
+    UHFRecv uhf(serial, (options.baudRate > 0) ? options.baudRate : 10000000L,
+                DEFAULT_RS485_CTL_PIN);
+    uhf.begin();
+
+    Database* databases = new Database[numReaders];
+    InventorySession** sessions = new InventorySession*[numReaders];
+    BusScheduler scheduler(uhf);
+    for (int i = 0; i < numReaders; i++) {
+        databases[i].begin();
+        sessions[i] = new InventorySession(uhf, databases[i]);
+        scheduler.addReader(*sessions[i], (byte)i, DEFAULT_RX_TIMEOUT);
+    }
+
+    uint32_t* sweeps = new uint32_t[options.numSessions];
+    uint32_t numFrames = 0;
+
+    uint32_t start = micros();
+    while (scheduler.getNumSweeps() < options.numSessions) {
+        uint32_t numSweeps = scheduler.getNumSweeps();
+        relay(host[1], bus, numReaders);
+        for (int i = 0; i < numReaders; i++) {
+            sims[i]->poll();
+            relay(bus[i], &host[1], 1);
+        }
+        scheduler.poll();
+        if (scheduler.getNumSweeps() != numSweeps)
+            sweeps[numSweeps] = scheduler.getSweepTime();
+    }
+    uint32_t elapsed = micros() - start;
+
+    uint32_t dbCards = 0;
+    for (int i = 0; i < numReaders; i++) {
+        numFrames += sims[i]->getNumFrames();
+        dbCards += databases[i].getDB().getSize();
+    }
+
+    std::sort(sweeps, sweeps + options.numSessions);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < options.numSessions; i++)
+        sum += sweeps[i];
+
+    printf("%5ld %7d %8u %8u %8u %9.1f %9u %9u %9u %10.1f\n",
+           tags, numReaders, options.numSessions, numFrames, dbCards,
+           (double)sum / options.numSessions,
+           sweeps[options.numSessions / 2],
+           sweeps[options.numSessions * 99 / 100],
+           sweeps[options.numSessions - 1],
+           options.numSessions * 1e6 / (elapsed ? elapsed : 1));
+
+    for (int i = 0; i < numReaders; i++) {
+        delete sessions[i];
+        delete sims[i];
+        close(bus[i]);
+    }
+    delete[] sweeps;
+    delete[] sessions;
+    delete[] databases;
+    delete[] sims;
+    delete[] bus;
+    close(host[0]);
+    close(host[1]);
+}
+
+int main(int argc, char* argv[])
+{
+    Options options = { -1, 0, 0, 0, 0, 0, 0, 0, MAX_CARDS, 1, 1000, 0 };
+    bool isMeasure = false;
+
+    int option;
+    while ((option = getopt(argc, argv, "mt:a:d:x:e:c:l:b:f:s:n:r:")) != -1) {
+        switch (option) {
+            case 'm': isMeasure = true; break;
+            case 't': options.tags = atol(optarg); break;
+            case 'a': options.arrivals = atof(optarg); break;
+            case 'd': options.departure = atof(optarg); break;
+            case 'x': options.noCard = atof(optarg); break;
+            case 'e': options.crcError = atof(optarg); break;
+            case 'c': options.corruption = atof(optarg); break;
+            case 'l': options.delay = atol(optarg); break;
+            case 'b': options.baudRate = atol(optarg); break;
+            case 'f': options.tagsPerFrame = atoi(optarg); break;
+            case 's': options.seed = atol(optarg); break;
+            case 'n': options.numSessions = atol(optarg); break;
+            case 'r': options.numReaders = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-m] [options] [N]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (isMeasure) {
+        if (options.numSessions == 0)
+            options.numSessions = 1;
+
+        if (options.numReaders > 0) {
+            if (options.numReaders > BUS_MAX_READERS) {
+                fprintf(stderr, "At most %d readers on a bus\n", BUS_MAX_READERS);
+                return 1;
+            }
+            printf(" tags readers   sweeps   frames  dbCards   mean_us    p50_us    p99_us    max_us   sweeps/s\n");
+            measureBus(options, (options.tags >= 0) ? options.tags : 15);
+            return 0;
+        }
+
+        printf(" tags sessions   frames dbCards   mean_us    p50_us    p99_us    max_us  sessions/s  statuses\n");
+        if (options.tags >= 0) {
+            measure(options, options.tags);
+        } else {
+            measure(options, 1);
+            measure(options, 15);
+            measure(options, 500);
+        }
+        return 0;
+    }
+
+    int numReaders = (optind < argc) ? atoi(argv[optind]) : 1;
+    if (numReaders <= 0) {
+        fprintf(stderr, "Usage: %s [-m] [options] [N]\n", argv[0]);
+        return 1;
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    return serve(options, numReaders);
+}